@@ -0,0 +1,113 @@
+#include "abstractionheuristic.h"
+#include <functional>
+#include <queue>
+
+void AbstractionHeuristic::prepare(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal, const CostProfile& profile)
+{
+    if (!m_built || m_version != model.version() || m_rows != model.rowCount() || m_cols != model.colCount()
+        || !m_profile.sameCosts(profile)) {
+        m_profile = profile;
+        buildBlocks(model);
+        m_goalBlock = -1;
+    }
+    if (m_goalBlock < 0 || goal != m_goal) {
+        m_goal = goal;
+        computeDistances();
+    }
+}
+
+void AbstractionHeuristic::buildBlocks(const GridModel& model)
+{
+    m_rows = model.rowCount();
+    m_cols = model.colCount();
+    m_version = model.version();
+    m_built = true;
+    m_blockRows = (m_rows + kBlockSize - 1) / kBlockSize;
+    m_blockCols = (m_cols + kBlockSize - 1) / kBlockSize;
+    m_blockMin.assign(m_blockRows * m_blockCols, std::numeric_limits<double>::infinity());
+    m_open.assign(m_blockRows * m_blockCols * 4, 0);
+    m_minCost = std::numeric_limits<double>::infinity();
+
+    for (int row = 0; row < m_rows; ++row) {
+        for (int col = 0; col < m_cols; ++col) {
+            const double cost = m_profile.cost(model.cellState(row, col));
+            if (cost < 0) continue;
+            const int block = (row / kBlockSize) * m_blockCols + col / kBlockSize;
+            m_blockMin[block] = std::min(m_blockMin[block], cost);
+            m_minCost = std::min(m_minCost, cost);
+
+            // only the moves down and right need checking, the opposite side of the neighbour block is the same move
+            if (row + 1 < m_rows && (row + 1) % kBlockSize == 0 && m_profile.cost(model.cellState(row + 1, col)) >= 0) {
+                m_open[block * 4 + 1] = 1;
+                m_open[(block + m_blockCols) * 4 + 0] = 1;
+            }
+            if (col + 1 < m_cols && (col + 1) % kBlockSize == 0 && m_profile.cost(model.cellState(row, col + 1)) >= 0) {
+                m_open[block * 4 + 3] = 1;
+                m_open[(block + 1) * 4 + 2] = 1;
+            }
+        }
+    }
+    if (m_minCost == std::numeric_limits<double>::infinity()) m_minCost = 1.0;
+}
+
+void AbstractionHeuristic::computeDistances()
+{
+    const int blocks = m_blockRows * m_blockCols;
+    const double infinity = std::numeric_limits<double>::infinity();
+    m_goalBlock = (m_goal.first / kBlockSize) * m_blockCols + m_goal.second / kBlockSize;
+    m_exitCost.assign(blocks * 4, infinity);
+
+    // dist[block * 4 + side] = lower bound from a cell on that side of the block (entered through it) to the goal
+    std::vector<double> dist(blocks * 4, infinity);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+
+    auto bounds = [this](int block, int& top, int& bottom, int& left, int& right) {
+        top = (block / m_blockCols) * kBlockSize;
+        left = (block % m_blockCols) * kBlockSize;
+        bottom = std::min(top + kBlockSize, m_rows) - 1;
+        right = std::min(left + kBlockSize, m_cols) - 1;
+    };
+
+    // inside the goal's block the goal is at least as far as its distance to the side
+    {
+        int top, bottom, left, right;
+        bounds(m_goalBlock, top, bottom, left, right);
+        const double minCost = m_blockMin[m_goalBlock];
+        const int toGoal[4] = {m_goal.first - top, bottom - m_goal.first, m_goal.second - left, right - m_goal.second};
+        for (int side = 0; side < 4; ++side) {
+            dist[m_goalBlock * 4 + side] = toGoal[side] * minCost;
+            queue.push({dist[m_goalBlock * 4 + side], m_goalBlock * 4 + side});
+        }
+    }
+
+    // backwards: block "from" can leave through exitSide into "block", entering it through the side facing "from"
+    const int stepRow[4] = {-1, 1, 0, 0};
+    const int stepCol[4] = {0, 0, -1, 1};
+    while (!queue.empty()) {
+        const auto [d, state] = queue.top();
+        queue.pop();
+        if (d > dist[state]) continue;
+        const int block = state / 4;
+        const int entrySide = state % 4;
+        if (!m_open[state]) continue;
+
+        const int from = block + stepRow[entrySide] * m_blockCols + stepCol[entrySide];
+        const int exitSide = entrySide ^ 1;
+        const double exitCost = m_blockMin[block] + d;
+        if (exitCost >= m_exitCost[from * 4 + exitSide]) continue;
+        m_exitCost[from * 4 + exitSide] = exitCost;
+
+        int top, bottom, left, right;
+        bounds(from, top, bottom, left, right);
+        const double minCost = m_blockMin[from];
+        for (int side = 0; side < 4; ++side) {
+            // crossing to the opposite side takes (size - 1) moves inside the block, any other side can be next to it
+            const int inside = side != (exitSide ^ 1) ? 0 : (side < 2 ? bottom - top : right - left);
+            const double newDist = inside * minCost + exitCost;
+            if (newDist < dist[from * 4 + side]) {
+                dist[from * 4 + side] = newDist;
+                queue.push({newDist, from * 4 + side});
+            }
+        }
+    }
+}
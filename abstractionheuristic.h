@@ -0,0 +1,75 @@
+#ifndef ABSTRACTIONHEURISTIC_H
+#define ABSTRACTIONHEURISTIC_H
+
+#include "gridmodel.h"
+#include "costprofile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+// Multi-resolution heuristic for the A* in Pathfinder.
+// The grid is split into 8x8 blocks, each annotated with the cheapest terrain inside it and with the sides where a move
+// into the neighbouring block is possible. A Dijkstra search on this coarse graph (from the goal's block) gives for
+// every block side a lower bound on the cost still to pay: crossing a block from one side to the opposite one takes at
+// least (block size - 1) moves at that block's cheapest cost, and entering a block costs at least its cheapest cell.
+// Unlike the Manhattan distance this knows about walls (a path around a long wall has to cross the blocks along it)
+// and about blocks without boost cells. The estimate never overestimates and is consistent, so A* stays optimal.
+// The block annotations are reused for as long as the terrain and the cost profile stay the same (GridModel::version()).
+class AbstractionHeuristic {
+public:
+    static constexpr int kBlockSize = 8;
+
+    // refreshes the coarse graph if the terrain or the profile's costs changed and recomputes the distances if the goal moved
+    void prepare(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal, const CostProfile& profile = CostProfile::standard());
+
+    // lower bound on the cost from (row, col) to the goal of the last prepare() (infinity if the goal cant be reached)
+    double estimate(uint8_t row, uint8_t col) const noexcept {
+        const int block = (row / kBlockSize) * m_blockCols + col / kBlockSize;
+        const double minCost = m_blockMin[block];
+        const int manhattan = std::abs(row - m_goal.first) + std::abs(col - m_goal.second);
+        double best = block == m_goalBlock ? manhattan * minCost : std::numeric_limits<double>::infinity();
+
+        // leave through one of the 4 sides (moves to reach it are paid at the block's cheapest cost)
+        const int top = row - row % kBlockSize;
+        const int left = col - col % kBlockSize;
+        const int toSide[4] = {row - top, std::min(top + kBlockSize, m_rows) - 1 - row,
+                               col - left, std::min(left + kBlockSize, m_cols) - 1 - col};
+        for (int side = 0; side < 4; ++side) best = std::min(best, toSide[side] * minCost + m_exitCost[block * 4 + side]);
+
+        // the block bound ignores moves that cut across block corners, so it can be weaker than the Manhattan
+        // distance on diagonal routes. both are lower bounds, take the better one.
+        return std::max(best, manhattan * m_minCost);
+    }
+
+private:
+    // recomputes the cheapest cost and the open sides of every block
+    void buildBlocks(const GridModel& model);
+
+    // Dijkstra from the goal's block over (block, side it was entered from) states
+    void computeDistances();
+
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_blockRows = 0;
+    int m_blockCols = 0;
+    std::uint64_t m_version = 0;
+    bool m_built = false;
+    CostProfile m_profile;
+
+    std::pair<uint8_t, uint8_t> m_goal {101, 101};
+    int m_goalBlock = -1;
+
+    // cheapest passable cell of the whole grid, and of every block (infinity if it has none)
+    double m_minCost = 1.0;
+    std::vector<double> m_blockMin;
+
+    // m_open[block * 4 + side]: a move across this side (up, down, left, right) into the next block is possible
+    std::vector<char> m_open;
+
+    // m_exitCost[block * 4 + side]: lower bound on the cost to the goal after leaving the block through this side
+    std::vector<double> m_exitCost;
+};
+
+#endif // ABSTRACTIONHEURISTIC_H
@@ -0,0 +1,154 @@
+#include "boostheuristic.h"
+#include "rectangularsymmetryreduction.h"
+#include <functional>
+#include <queue>
+
+void BoostHeuristic::prepare(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal, const CostProfile& profile)
+{
+    if (!m_built || m_version != model.version() || m_rows != model.rowCount() || m_cols != model.colCount()
+        || !m_profile.sameCosts(profile)) {
+        buildGraph(model, profile);
+        m_goalReady = false;
+    }
+    if (!m_goalReady || goal != m_goal) {
+        m_goal = goal;
+        m_goalReady = true;
+        if (!m_fallback) computeDistances();
+    }
+}
+
+void BoostHeuristic::buildGraph(const GridModel& model, const CostProfile& profile)
+{
+    m_rows = model.rowCount();
+    m_cols = model.colCount();
+    m_blockCols = (m_cols + kBlockSize - 1) / kBlockSize;
+    m_version = model.version();
+    m_built = true;
+    m_profile = profile;
+    m_fallbackCost = profile.minCost();
+
+    // cheapest step that isnt boost (impassable terrain doesnt count)
+    const double normal = profile.cost(GridModel::Normal);
+    const double rough = profile.cost(GridModel::Rough);
+    m_boostCost = profile.cost(GridModel::Boost);
+    m_stepCost = std::numeric_limits<double>::infinity();
+    if (normal >= 0) m_stepCost = std::min(m_stepCost, normal);
+    if (rough >= 0) m_stepCost = std::min(m_stepCost, rough);
+
+    // the relaxed map only helps when boost is passable and strictly cheaper than everything else
+    m_rects.clear();
+    m_fallback = m_boostCost < 0 || !(m_boostCost < m_stepCost) || m_stepCost == std::numeric_limits<double>::infinity();
+    if (m_fallback) return;
+
+    // the boost rectangles are the boost parts of the symmetry reduction's decomposition (its standard costs keep
+    // boost cells apart from every other terrain, whatever the profile)
+    const RectangularSymmetryReduction reduction(model);
+    for (const auto& rect : reduction.rects()) {
+        if (rect.top <= rect.bottom && model.cellState(rect.top, rect.left) == GridModel::Boost) {
+            m_rects.push_back({rect.top, rect.left, rect.bottom, rect.right});
+        }
+    }
+    m_fallback = m_rects.size() > static_cast<size_t>(kMaxRects);
+    if (m_fallback) return;
+
+    m_boostIndex.assign(m_rows * m_cols, -1);
+    m_boostCells.clear();
+    m_rectOf.clear();
+    for (int id = 0; id < static_cast<int>(m_rects.size()); ++id) {
+        const Rect& rect = m_rects[id];
+        for (int r = rect.top; r <= rect.bottom; ++r) {
+            for (int c = rect.left; c <= rect.right; ++c) {
+                m_boostIndex[r * m_cols + c] = static_cast<int>(m_boostCells.size());
+                m_boostCells.push_back(r * m_cols + c);
+                m_rectOf.push_back(id);
+            }
+        }
+    }
+
+    // jumps from every boost cell to the closest cell of every other rectangle, stored by target (CSR)
+    const int count = static_cast<int>(m_boostCells.size());
+    std::vector<int> targets;
+    targets.reserve(static_cast<size_t>(count) * m_rects.size());
+    m_jumpStart.assign(count + 1, 0);
+    for (int u = 0; u < count; ++u) {
+        const int row = m_boostCells[u] / m_cols;
+        const int col = m_boostCells[u] % m_cols;
+        for (int id = 0; id < static_cast<int>(m_rects.size()); ++id) {
+            if (id == m_rectOf[u]) continue;
+            const Rect& rect = m_rects[id];
+            const int v = m_boostIndex[std::clamp<int>(row, rect.top, rect.bottom) * m_cols + std::clamp<int>(col, rect.left, rect.right)];
+            targets.push_back(v);
+            ++m_jumpStart[v + 1];
+        }
+    }
+    for (int v = 0; v < count; ++v) m_jumpStart[v + 1] += m_jumpStart[v];
+    m_jumpsFrom.resize(targets.size());
+    std::vector<int> fill(m_jumpStart.begin(), m_jumpStart.end() - 1);
+    size_t next = 0;
+    for (int u = 0; u < count; ++u) {
+        for (size_t id = 0; id + 1 < m_rects.size(); ++id) m_jumpsFrom[fill[targets[next++]]++] = u;
+    }
+}
+
+void BoostHeuristic::computeDistances()
+{
+    const int count = static_cast<int>(m_boostCells.size());
+    auto manhattan = [this](int cell, int row, int col) {
+        return std::abs(cell / m_cols - row) + std::abs(cell % m_cols - col);
+    };
+
+    // every boost cell can at least walk straight to the goal, then Dijkstra backwards over boost steps and jumps
+    m_dist.resize(count);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+    for (int u = 0; u < count; ++u) {
+        m_dist[u] = manhattan(m_boostCells[u], m_goal.first, m_goal.second) * m_stepCost;
+        queue.push({m_dist[u], u});
+    }
+    auto relax = [&](int u, double cost) {
+        if (cost < m_dist[u]) {
+            m_dist[u] = cost;
+            queue.push({cost, u});
+        }
+    };
+    const int dr[4] = {-1, 1, 0, 0};
+    const int dc[4] = {0, 0, -1, 1};
+    while (!queue.empty()) {
+        const auto [d, v] = queue.top();
+        queue.pop();
+        if (d > m_dist[v]) continue;
+        const int row = m_boostCells[v] / m_cols;
+        const int col = m_boostCells[v] % m_cols;
+        for (int direction = 0; direction < 4; ++direction) {
+            const int r = row + dr[direction];
+            const int c = col + dc[direction];
+            if (r < 0 || r >= m_rows || c < 0 || c >= m_cols || m_boostIndex[r * m_cols + c] < 0) continue;
+            relax(m_boostIndex[r * m_cols + c], d + m_boostCost);
+        }
+        for (int i = m_jumpStart[v]; i < m_jumpStart[v + 1]; ++i) {
+            const int u = m_jumpsFrom[i];
+            relax(u, d + (manhattan(m_boostCells[u], row, col) - 1) * m_stepCost + m_boostCost);
+        }
+    }
+
+    // a rectangle only matters for a block if going through it could beat walking straight to the goal from somewhere
+    // in the block: compare the cheapest way through the rectangle with the block's farthest corner
+    std::vector<double> rectMin(m_rects.size(), std::numeric_limits<double>::infinity());
+    for (int u = 0; u < count; ++u) rectMin[m_rectOf[u]] = std::min(rectMin[m_rectOf[u]], m_dist[u]);
+    const int blockRows = (m_rows + kBlockSize - 1) / kBlockSize;
+    m_candidateStart.assign(blockRows * m_blockCols + 1, 0);
+    m_candidates.clear();
+    for (int block = 0; block < blockRows * m_blockCols; ++block) {
+        const int top = (block / m_blockCols) * kBlockSize;
+        const int left = (block % m_blockCols) * kBlockSize;
+        const int bottom = std::min(top + kBlockSize, m_rows) - 1;
+        const int right = std::min(left + kBlockSize, m_cols) - 1;
+        const int farthest = std::max(std::abs(top - m_goal.first), std::abs(bottom - m_goal.first))
+                           + std::max(std::abs(left - m_goal.second), std::abs(right - m_goal.second));
+        for (int id = 0; id < static_cast<int>(m_rects.size()); ++id) {
+            const Rect& rect = m_rects[id];
+            const int gap = std::max({0, rect.top - bottom, top - rect.bottom}) + std::max({0, rect.left - right, left - rect.right});
+            if ((gap - 1) * m_stepCost + m_boostCost + rectMin[id] < farthest * m_stepCost) m_candidates.push_back(id);
+        }
+        m_candidateStart[block + 1] = static_cast<int>(m_candidates.size());
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef BOOSTHEURISTIC_H
+#define BOOSTHEURISTIC_H
+
+#include "gridmodel.h"
+#include "costprofile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+// Boost-aware heuristic for the A* in Pathfinder.
+// Scaling every step by the boost cost (0.5) just because a boost cell exists somewhere throws away half of the
+// heuristic. Instead, this computes the exact cost in a relaxed map without walls where every cell costs a normal
+// step except the boost cells: the Manhattan distance at full cost, unless using one of the boost rectangles is
+// cheaper. For that a small graph over the boost cells is searched from the goal, where each cell links to its boost
+// neighbours and to the closest cell of every other boost rectangle (the cheapest way over to it, because moving
+// inside a rectangle is cheaper than outside). A cell outside of all boost areas then only needs the closest cell of
+// each nearby rectangle. Being an exact distance in a relaxed map, it never overestimates and is consistent.
+// With too many boost rectangles the graph would get too large and it falls back to the old 0.5-scaled distance.
+// Costs come from a CostProfile: if boost isnt the profile's cheapest terrain there is nothing to gain, and the
+// estimate is simply the Manhattan distance at the profile's cheapest cost.
+class BoostHeuristic {
+public:
+    // more boost rectangles than this fall back to the scaled Manhattan distance
+    static constexpr int kMaxRects = 64;
+
+    // refreshes the boost rectangles if the terrain or the profile's costs changed and recomputes the distances if the goal moved
+    void prepare(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal, const CostProfile& profile = CostProfile::standard());
+
+    // lower bound on the cost from (row, col) to the goal of the last prepare()
+    double estimate(uint8_t row, uint8_t col) const noexcept {
+        const int manhattan = std::abs(row - m_goal.first) + std::abs(col - m_goal.second);
+        if (m_fallback) return manhattan * m_fallbackCost;
+
+        const int boost = m_boostIndex[row * m_cols + col];
+        if (boost >= 0) return m_dist[boost];
+
+        // walk straight to the goal, or to the closest cell of a boost rectangle and continue from there
+        double best = manhattan * m_stepCost;
+        const int block = (row / kBlockSize) * m_blockCols + col / kBlockSize;
+        for (int i = m_candidateStart[block]; i < m_candidateStart[block + 1]; ++i) {
+            const Rect& rect = m_rects[m_candidates[i]];
+            const int r = std::clamp<int>(row, rect.top, rect.bottom);
+            const int c = std::clamp<int>(col, rect.left, rect.right);
+            const int distance = std::abs(row - r) + std::abs(col - c);
+            best = std::min(best, (distance - 1) * m_stepCost + m_boostCost + m_dist[m_boostIndex[r * m_cols + c]]);
+        }
+        return best;
+    }
+
+private:
+    // cells are grouped in blocks of this size to keep a short list of useful rectangles per block
+    static constexpr int kBlockSize = 8;
+
+    struct Rect {
+        uint8_t top;
+        uint8_t left;
+        uint8_t bottom;
+        uint8_t right;
+    };
+
+    // finds the boost rectangles and the links between boost cells
+    void buildGraph(const GridModel& model, const CostProfile& profile);
+
+    // Dijkstra from the goal over the boost cells, then the rectangles worth checking for every block
+    void computeDistances();
+
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_blockCols = 0;
+    std::uint64_t m_version = 0;
+    bool m_built = false;
+    bool m_fallback = true;
+    bool m_goalReady = false;
+    std::pair<uint8_t, uint8_t> m_goal {101, 101};
+
+    // cost of a boost step and of the cheapest other step, and the cost per Manhattan step of the fallback
+    double m_boostCost = 0.5;
+    double m_stepCost = 1.0;
+    double m_fallbackCost = 0.5;
+    CostProfile m_profile;
+
+    std::vector<Rect> m_rects;
+
+    // index of every cell among the boost cells (-1 for others), their cells and rectangles
+    std::vector<int> m_boostIndex;
+    std::vector<int> m_boostCells;
+    std::vector<int> m_rectOf;
+
+    // jumps: m_jumpsFrom[m_jumpStart[v] .. m_jumpStart[v + 1]) are the boost cells whose closest cell in v's rectangle is v
+    std::vector<int> m_jumpStart;
+    std::vector<int> m_jumpsFrom;
+
+    // cost from every boost cell to the goal in the relaxed map
+    std::vector<double> m_dist;
+
+    // rectangles worth checking for each block: m_candidates[m_candidateStart[block] .. m_candidateStart[block + 1])
+    std::vector<int> m_candidateStart;
+    std::vector<int> m_candidates;
+};
+
+#endif // BOOSTHEURISTIC_H
@@ -0,0 +1,353 @@
+#include "compressedpathdatabase.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+
+namespace {
+// a run stores the move in the lowest 2 bits and the rank of the first target it covers in the rest
+constexpr uint32_t kMoveBits = 2;
+constexpr uint32_t kMoveMask = 3;
+
+// marks targets whose first move doesnt matter (walls, unreachable cells, the source itself).
+// they are simply covered by whatever run is active, which makes the runs longer.
+constexpr uint8_t kAnyMove = GridGraph::kNoMove;
+
+// file header, "CPD" + format number
+constexpr uint32_t kFileMagic = 0x31445043;
+
+// helpers to write/read a whole vector of plain numbers
+template <typename T>
+void writeVector(std::ofstream& out, const std::vector<T>& values) {
+    const uint64_t count = values.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+bool readVector(std::ifstream& in, std::vector<T>& values, uint64_t maxCount) {
+    uint64_t count = 0;
+    if (!in.read(reinterpret_cast<char*>(&count), sizeof(count)) || count > maxCount) return false;
+
+    // a damaged count must not allocate more than the file can hold
+    const std::streampos position = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streamoff remaining = in.tellg() - position;
+    in.seekg(position);
+    if (!in || remaining < 0 || count > static_cast<uint64_t>(remaining) / sizeof(T)) return false;
+
+    values.resize(count);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T))));
+}
+}
+
+CompressedPathDatabase::CompressedPathDatabase() : m_state(std::make_shared<State>()) {}
+
+void CompressedPathDatabase::build(const GridModel& model, const CostProfile& profile)
+{
+    auto table = buildTable(GridGraph(model, profile));
+
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    // a blocking build counts as the newest request, any older background build is now outdated
+    m_state->installedBuild = ++m_state->requestedBuild;
+    m_state->table = std::move(table);
+}
+
+void CompressedPathDatabase::rebuildAsync(const GridModel& model, const CostProfile& profile)
+{
+    // the snapshot is taken here on the calling (UI) thread, so the worker never touches the GridModel
+    GridGraph graph(model, profile);
+
+    uint64_t buildId;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        buildId = ++m_state->requestedBuild;
+        ++m_state->runningBuilds;
+    }
+
+    // the job only holds the shared state, not "this"
+    std::shared_ptr<State> state = m_state;
+    WorkerPool::instance().submit([state, buildId, graph = std::move(graph)]() mutable {
+        std::shared_ptr<const Table> table;
+        try {
+            table = buildTable(std::move(graph));
+        } catch (...) {
+            // out of memory etc, keep the old table
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        --state->runningBuilds;
+        // only install if no newer table is already in place
+        if (table && buildId > state->installedBuild) {
+            state->installedBuild = buildId;
+            state->table = std::move(table);
+        }
+    });
+}
+
+bool CompressedPathDatabase::isReady() const
+{
+    return table() != nullptr;
+}
+
+bool CompressedPathDatabase::isRebuilding() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->runningBuilds > 0;
+}
+
+bool CompressedPathDatabase::isUpToDate(const GridModel& model) const
+{
+    const auto current = table();
+    return current && current->graph.version() == model.version()
+           && current->graph.rowCount() == model.rowCount() && current->graph.colCount() == model.colCount();
+}
+
+std::shared_ptr<const CompressedPathDatabase::Table> CompressedPathDatabase::table() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->table;
+}
+
+std::vector<uint32_t> CompressedPathDatabase::depthFirstRanks(const GridGraph& graph)
+{
+    // cells close together in the depth first order are close together on the map, and cells in the same
+    // "branch" of the search tree tend to share their first move, which is what makes the runs long
+    const int n = graph.size();
+    std::vector<uint32_t> rank(n, std::numeric_limits<uint32_t>::max());
+    std::vector<int> stack;
+    uint32_t next = 0;
+
+    for (int root = 0; root < n; ++root) {
+        if (!graph.passable(root) || rank[root] != std::numeric_limits<uint32_t>::max()) continue;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            const int current = stack.back();
+            stack.pop_back();
+            if (rank[current] != std::numeric_limits<uint32_t>::max()) continue;
+            rank[current] = next++;
+            // push in reverse so "up" is explored first, like the A* loop order
+            for (int direction = 3; direction >= 0; --direction) {
+                const int nb = graph.neighbour(current, direction);
+                if (nb >= 0 && rank[nb] == std::numeric_limits<uint32_t>::max()) stack.push_back(nb);
+            }
+        }
+    }
+
+    // walls are never targets, put them at the end
+    for (int i = 0; i < n; ++i) {
+        if (rank[i] == std::numeric_limits<uint32_t>::max()) rank[i] = next++;
+    }
+    return rank;
+}
+
+std::shared_ptr<const CompressedPathDatabase::Table> CompressedPathDatabase::buildTable(GridGraph graph)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    auto table = std::make_shared<Table>();
+    const int n = graph.size();
+    table->rank = depthFirstRanks(graph);
+    table->component = graph.components();
+
+    // order[k] = the cell with rank k
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) order[table->rank[i]] = i;
+
+    // runs of every source, filled in parallel (each source writes only its own vector)
+    std::vector<std::vector<uint32_t>> rows(n);
+
+    WorkerPool::instance().parallelFor(n, [&](int begin, int end) {
+        // scratch buffers reused for every source in this chunk
+        std::vector<double> dist;
+        std::vector<uint8_t> firstMove;
+
+        for (int source = begin; source < end; ++source) {
+            if (!graph.passable(source)) continue;
+
+            // first move of a cheapest path from source to every target
+            graph.firstMoves(source, dist, firstMove);
+
+            // run length encode the first moves in target order
+            auto& row = rows[source];
+            uint8_t active = kAnyMove;
+            for (int k = 0; k < n; ++k) {
+                const uint8_t move = firstMove[order[k]];
+                if (move == kAnyMove || move == active) continue;
+                // the first run always starts at rank 0 so every lookup finds a run
+                const uint32_t runStart = row.empty() ? 0 : static_cast<uint32_t>(k);
+                row.push_back((runStart << kMoveBits) | move);
+                active = move;
+            }
+            row.shrink_to_fit();
+        }
+    });
+
+    // glue all rows into one flat array
+    table->rowOffsets.resize(n + 1, 0);
+    for (int source = 0; source < n; ++source) {
+        table->rowOffsets[source + 1] = table->rowOffsets[source] + static_cast<uint32_t>(rows[source].size());
+    }
+    table->runs.reserve(table->rowOffsets[n]);
+    for (auto& row : rows) {
+        table->runs.insert(table->runs.end(), row.begin(), row.end());
+        // free each row straight away to keep the peak memory down
+        std::vector<uint32_t>().swap(row);
+    }
+
+    table->graph = std::move(graph);
+    table->buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    return table;
+}
+
+int CompressedPathDatabase::lookup(const Table& table, int source, uint32_t targetRank)
+{
+    const auto first = table.runs.begin() + table.rowOffsets[source];
+    const auto last = table.runs.begin() + table.rowOffsets[source + 1];
+    if (first == last) return -1;
+
+    // find the last run that starts at or before the target (runs are sorted by their start rank)
+    const uint32_t key = (targetRank << kMoveBits) | kMoveMask;
+    const auto it = std::upper_bound(first, last, key);
+    // every row starts with a run at rank 0, so this only happens with a damaged table
+    if (it == first) return -1;
+    return static_cast<int>(*(it - 1) & kMoveMask);
+}
+
+int CompressedPathDatabase::firstMove(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    const auto current = table();
+    if (!current) return -1;
+    const GridGraph& graph = current->graph;
+    if (start.first >= graph.rowCount() || start.second >= graph.colCount()
+        || goal.first >= graph.rowCount() || goal.second >= graph.colCount()) return -1;
+
+    const int s = graph.index(start);
+    const int t = graph.index(goal);
+    // different components (or walls) means there is no path, and there is no move from a cell to itself
+    if (s == t || current->component[s] < 0 || current->component[s] != current->component[t]) return -1;
+    return lookup(*current, s, current->rank[t]);
+}
+
+Pathfinder::PathResult CompressedPathDatabase::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+
+    const auto current = table();
+    if (!current) return result;
+    const GridGraph& graph = current->graph;
+    if (start.first >= graph.rowCount() || start.second >= graph.colCount()
+        || goal.first >= graph.rowCount() || goal.second >= graph.colCount()) return result;
+
+    const int s = graph.index(start);
+    const int t = graph.index(goal);
+    if (current->component[s] < 0 || current->component[s] != current->component[t]) return result;
+
+    // follow first moves: every cell on an optimal path has the rest of that path as an optimal path too,
+    // so repeating the lookup from each new cell walks along an optimal path to the goal
+    const uint32_t targetRank = current->rank[t];
+    int cell = s;
+    result.totalCost = 0.0;
+    result.path.push_back(start);
+    while (cell != t) {
+        const int move = lookup(*current, cell, targetRank);
+        const int next = move < 0 ? -1 : graph.neighbour(cell, move);
+        // a damaged table could send us in circles, a real path never visits more cells than exist
+        if (next < 0 || static_cast<int>(result.path.size()) > graph.size()) return {{}, -1};
+        cell = next;
+        result.totalCost += graph.cost(cell);
+        result.path.push_back(graph.cell(cell));
+    }
+    return result;
+}
+
+bool CompressedPathDatabase::save(const std::string& fileName) const
+{
+    const auto current = table();
+    if (!current) return false;
+
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) return false;
+
+    // header: magic number, map size and a hash of the map so load() can refuse tables of other maps
+    const int32_t rows = current->graph.rowCount();
+    const int32_t cols = current->graph.colCount();
+    const uint64_t fingerprint = current->graph.fingerprint();
+    out.write(reinterpret_cast<const char*>(&kFileMagic), sizeof(kFileMagic));
+    out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    out.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+    out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+
+    writeVector(out, current->rank);
+    writeVector(out, current->component);
+    writeVector(out, current->rowOffsets);
+    writeVector(out, current->runs);
+    return static_cast<bool>(out);
+}
+
+bool CompressedPathDatabase::load(const std::string& fileName, const GridModel& model, const CostProfile& profile)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) return false;
+
+    GridGraph graph(model, profile);
+    uint32_t magic = 0;
+    int32_t rows = 0;
+    int32_t cols = 0;
+    uint64_t fingerprint = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+    in.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+    in.read(reinterpret_cast<char*>(&fingerprint), sizeof(fingerprint));
+    if (!in || magic != kFileMagic || rows != graph.rowCount() || cols != graph.colCount() || fingerprint != graph.fingerprint()) return false;
+
+    auto table = std::make_shared<Table>();
+    const uint64_t n = static_cast<uint64_t>(graph.size());
+    if (!readVector(in, table->rank, n) || !readVector(in, table->component, n)
+        || !readVector(in, table->rowOffsets, n + 1) || !readVector(in, table->runs, n * n)) return false;
+
+    // basic sanity checks so a damaged file cant make lookups read out of bounds
+    if (table->rank.size() != n || table->component.size() != n || table->rowOffsets.size() != n + 1
+        || table->rowOffsets.back() != table->runs.size()
+        || table->rowOffsets.front() != 0 || !std::is_sorted(table->rowOffsets.begin(), table->rowOffsets.end())) return false;
+    for (uint64_t cell = 0; cell < n; ++cell) {
+        if (table->rank[cell] >= n || table->component[cell] < -1 || table->component[cell] >= static_cast<int>(n)) return false;
+    }
+
+    // runs of every source: the first one starts at rank 0, then strictly increasing start ranks below n
+    // (the move is the low 2 bits, so it is always a valid direction)
+    for (uint64_t source = 0; source < n; ++source) {
+        const uint32_t begin = table->rowOffsets[source];
+        const uint32_t end = table->rowOffsets[source + 1];
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint32_t start = table->runs[i] >> kMoveBits;
+            if (start >= n || (i == begin ? start != 0 : start <= (table->runs[i - 1] >> kMoveBits))) return false;
+        }
+    }
+
+    table->graph = std::move(graph);
+
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->installedBuild = ++m_state->requestedBuild;
+    m_state->table = std::move(table);
+    return true;
+}
+
+CompressedPathDatabase::Stats CompressedPathDatabase::stats() const
+{
+    Stats stats;
+    const auto current = table();
+    if (!current) return stats;
+    stats.nodes = current->graph.size();
+    stats.runs = current->runs.size();
+    stats.bytes = sizeof(Table)
+                  + current->graph.size() * sizeof(double)
+                  + current->rank.size() * sizeof(uint32_t)
+                  + current->component.size() * sizeof(int)
+                  + current->rowOffsets.size() * sizeof(uint32_t)
+                  + current->runs.size() * sizeof(uint32_t);
+    stats.buildMilliseconds = current->buildMilliseconds;
+    return stats;
+}
@@ -0,0 +1,102 @@
+#ifndef COMPRESSEDPATHDATABASE_H
+#define COMPRESSEDPATHDATABASE_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Compressed Path Database (CPD).
+// For every source cell it stores the first move (up/down/left/right) of an optimal path towards every target cell.
+// A path query then needs no search at all: look up the first move from start, step, look up again, ... until the goal.
+// Storing one move per (source, target) pair would be rows*cols squared entries, so each source's row of moves is
+// run length encoded. Targets are numbered in depth first order first, which keeps neighbouring cells next to each
+// other so long runs of the same move appear (all targets "behind" a wall share one first move).
+// Meant for static maps that get queried a lot: building takes one Dijkstra per cell (run in parallel on the
+// WorkerPool), and the table has to be rebuilt after the map changes (rebuildAsync() does this in the background).
+class CompressedPathDatabase {
+public:
+    // size / speed information about the current table
+    struct Stats {
+        int nodes = 0;                 // number of cells
+        size_t runs = 0;               // total number of run length encoded entries
+        size_t bytes = 0;              // memory used by the table
+        double buildMilliseconds = 0;  // time it took to build (0 if loaded from disk)
+    };
+
+    CompressedPathDatabase();
+
+    // builds the table for the current grid and waits for it (uses every worker thread).
+    // a table holds the paths of one cost profile, keep one database per profile that needs one
+    void build(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // takes a snapshot of the grid now and builds the table in the background on the WorkerPool.
+    // queries keep using the previous table until the new one is finished. if this is called again before the
+    // build is done (e.g. the user keeps drawing walls) the newest build wins and older ones are thrown away.
+    void rebuildAsync(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // true once a table is available for queries
+    bool isReady() const;
+
+    // true while a background build is running
+    bool isRebuilding() const;
+
+    // true if the current table was built from exactly this version of the grid
+    bool isUpToDate(const GridModel& model) const;
+
+    // first move of an optimal path from start to goal as an index into GridGraph::dr/dc, or -1 if there is no path
+    int firstMove(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // optimal path found by following first moves, same result format as Pathfinder::findPath()
+    // (totalCost is -1 if there is no path or no table yet)
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // writes the table to a binary file. returns false if the file couldnt be written or there is no table
+    bool save(const std::string& fileName) const;
+
+    // reads a table written by save(). returns false if the file is missing, damaged or belongs to a different map
+    // (or was written for other costs than the profile's).
+    bool load(const std::string& fileName, const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    Stats stats() const;
+
+private:
+    // everything a query needs, never changed after it is built so threads can share it without locking
+    struct Table {
+        GridGraph graph;                  // costs of the map the table was built for
+        std::vector<uint32_t> rank;       // position of every cell in the depth first target order
+        std::vector<int> component;       // connected component of every cell (-1 for walls)
+        std::vector<uint32_t> rowOffsets; // runs of source s are runs[rowOffsets[s] .. rowOffsets[s + 1])
+        std::vector<uint32_t> runs;       // (first target rank << 2) | move
+        double buildMilliseconds = 0;
+    };
+
+    // state shared with background builds, kept in a shared_ptr so a build can finish safely even if the
+    // database was destroyed in the meantime
+    struct State {
+        mutable std::mutex mutex;
+        std::shared_ptr<const Table> table;
+        uint64_t requestedBuild = 0;   // id of the newest requested build
+        uint64_t installedBuild = 0;   // id of the build currently in "table"
+        int runningBuilds = 0;
+    };
+
+    // runs the actual preprocessing
+    static std::shared_ptr<const Table> buildTable(GridGraph graph);
+
+    // depth first order of all cells (walls at the end)
+    static std::vector<uint32_t> depthFirstRanks(const GridGraph& graph);
+
+    // binary search in the runs of a source for the move towards the target with the given rank
+    static int lookup(const Table& table, int source, uint32_t targetRank);
+
+    // current table (or nullptr), copied under the lock
+    std::shared_ptr<const Table> table() const;
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // COMPRESSEDPATHDATABASE_H
@@ -0,0 +1,204 @@
+#include "conflictbasedsearch.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+ConflictBasedSearch::ConflictBasedSearch(const GridModel& model)
+    : m_graph(model)
+{
+}
+
+void ConflictBasedSearch::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    m_graph.refreshCell(model, row, col);
+}
+
+std::unique_ptr<ConflictBasedSearch::SearchContext> ConflictBasedSearch::takeContext()
+{
+    std::lock_guard<std::mutex> lock(m_contextMutex);
+    if (m_contexts.empty()) return std::make_unique<SearchContext>(m_graph);
+    std::unique_ptr<SearchContext> context = std::move(m_contexts.back());
+    m_contexts.pop_back();
+    return context;
+}
+
+void ConflictBasedSearch::returnContext(std::unique_ptr<SearchContext> context)
+{
+    std::lock_guard<std::mutex> lock(m_contextMutex);
+    m_contexts.push_back(std::move(context));
+}
+
+ConflictBasedSearch::Conflict ConflictBasedSearch::firstConflict(const TreeNode& node) const
+{
+    const int count = static_cast<int>(node.paths.size());
+    size_t end = 0;
+    for (const auto& path : node.paths) end = std::max(end, path->size());
+
+    // agents stay on their goal once their path ends
+    auto at = [&](int agent, size_t time) {
+        const std::vector<int>& path = *node.paths[agent];
+        return path[std::min(time, path.size() - 1)];
+    };
+
+    for (size_t time = 0; time < end; ++time) {
+        for (int a = 0; a < count; ++a) {
+            for (int b = a + 1; b < count; ++b) {
+                if (at(a, time) == at(b, time)) return {a, b, at(a, time), -1, static_cast<int>(time)};
+                if (time + 1 < end && at(a, time) != at(a, time + 1) && at(a, time) == at(b, time + 1) && at(b, time) == at(a, time + 1)) {
+                    return {a, b, at(a, time), at(a, time + 1), static_cast<int>(time)};
+                }
+            }
+        }
+    }
+    return {};
+}
+
+std::shared_ptr<ConflictBasedSearch::TreeNode> ConflictBasedSearch::child(const std::shared_ptr<const TreeNode>& parent, const Constraint& constraint,
+                                                                          const std::vector<int>& starts, const std::vector<int>& goals,
+                                                                          std::vector<GoalDistance>& distances, long long& expanded)
+{
+    const int agent = constraint.agent;
+    std::unique_ptr<SearchContext> context = takeContext();
+
+    // the new constraint plus every constraint on the same agent further up the tree
+    context->constraints.clear();
+    auto add = [&](const Constraint& c) {
+        if (c.agent != agent || c.cell < 0) return;
+        if (c.to < 0) {
+            context->constraints.reserveCell(c.cell, c.time);
+        } else {
+            // a reserved move to -> cell is what blocks the move cell -> to
+            context->constraints.reserveMove(c.to, c.cell, c.time);
+        }
+    };
+    add(constraint);
+    for (const TreeNode* node = parent.get(); node; node = node->parent.get()) add(node->constraint);
+
+    std::shared_ptr<TreeNode> result;
+    if (context->search.search(starts[agent], goals[agent], 0, 0, context->constraints, distances[agent], context->cells)) {
+        result = std::make_shared<TreeNode>(*parent);
+        result->parent = parent;
+        result->constraint = constraint;
+        double cost = 0.0;
+        for (size_t t = 1; t < context->cells.size(); ++t) cost += SpaceTimeSearch::stepCost(m_graph, context->cells[t - 1], context->cells[t], goals[agent]);
+        result->cost += cost - result->costs[agent];
+        result->costs[agent] = cost;
+        result->paths[agent] = std::make_shared<const std::vector<int>>(context->cells);
+    }
+    expanded += context->search.lastExpanded();
+    returnContext(std::move(context));
+    return result;
+}
+
+ConflictBasedSearch::Result ConflictBasedSearch::solve(const std::vector<Agent>& agents, int maxNodes)
+{
+    const int count = static_cast<int>(agents.size());
+    std::vector<int> starts, goals;
+    for (const Agent& agent : agents) {
+        if (agent.start.first >= m_graph.rowCount() || agent.start.second >= m_graph.colCount()
+            || agent.goal.first >= m_graph.rowCount() || agent.goal.second >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+        starts.push_back(m_graph.index(agent.start));
+        goals.push_back(m_graph.index(agent.goal));
+    }
+
+    Result result;
+    std::atomic<long long> lowLevelExpanded = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!m_graph.passable(starts[i]) || !m_graph.passable(goals[i])) return result;
+    }
+
+    // complete distance tables, so the worker threads can share them without writing
+    std::vector<GoalDistance> distances;
+    for (int i = 0; i < count; ++i) distances.emplace_back(m_graph, goals[i], starts[i]);
+    WorkerPool::instance().parallelFor(count, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) distances[i].settleAll();
+    });
+
+    // root: every agent on its own. a child of an empty node with an empty constraint is exactly that, so the root is
+    // put together from one such child per agent
+    auto root = std::make_shared<TreeNode>();
+    root->paths.resize(count);
+    root->costs.assign(count, 0.0);
+    std::vector<std::shared_ptr<TreeNode>> alone(count);
+    WorkerPool::instance().parallelFor(count, [&](int begin, int end) {
+        long long expanded = 0;
+        for (int i = begin; i < end; ++i) alone[i] = child(root, Constraint{i}, starts, goals, distances, expanded);
+        lowLevelExpanded += expanded;
+    });
+    result.lowLevelExpanded = lowLevelExpanded;
+    for (int i = 0; i < count; ++i) {
+        if (!alone[i]) return result;
+        root->paths[i] = alone[i]->paths[i];
+        root->costs[i] = alone[i]->costs[i];
+        root->cost += root->costs[i];
+    }
+
+    // cheapest node first, older nodes first on ties
+    auto later = [](const std::shared_ptr<const TreeNode>& a, const std::shared_ptr<const TreeNode>& b) {
+        return a->cost != b->cost ? a->cost > b->cost : a->id > b->id;
+    };
+    std::priority_queue<std::shared_ptr<const TreeNode>, std::vector<std::shared_ptr<const TreeNode>>, decltype(later)> open(later);
+    open.push(root);
+    int nextId = 1;
+    const size_t batchSize = WorkerPool::instance().threadCount() + 1;
+
+    std::shared_ptr<const TreeNode> solution;
+    std::vector<std::shared_ptr<const TreeNode>> batch;
+    std::vector<Conflict> conflicts;
+    std::vector<std::shared_ptr<TreeNode>> children;
+    while (!open.empty() && result.nodes < maxNodes) {
+        // a conflict free node beats everything that costs at least as much
+        if (solution && open.top()->cost >= solution->cost) break;
+
+        batch.clear();
+        while (!open.empty() && batch.size() < batchSize && (!solution || open.top()->cost < solution->cost)) {
+            batch.push_back(open.top());
+            open.pop();
+        }
+        conflicts.assign(batch.size(), {});
+        children.assign(batch.size() * 2, nullptr);
+
+        WorkerPool::instance().parallelFor(static_cast<int>(batch.size()), [&](int begin, int end) {
+            long long expanded = 0;
+            for (int k = begin; k < end; ++k) {
+                const Conflict conflict = firstConflict(*batch[k]);
+                conflicts[k] = conflict;
+                if (conflict.a < 0) continue;
+                if (conflict.to < 0) {
+                    children[k * 2] = child(batch[k], {conflict.a, conflict.cell, -1, conflict.time}, starts, goals, distances, expanded);
+                    children[k * 2 + 1] = child(batch[k], {conflict.b, conflict.cell, -1, conflict.time}, starts, goals, distances, expanded);
+                } else {
+                    children[k * 2] = child(batch[k], {conflict.a, conflict.cell, conflict.to, conflict.time}, starts, goals, distances, expanded);
+                    children[k * 2 + 1] = child(batch[k], {conflict.b, conflict.to, conflict.cell, conflict.time}, starts, goals, distances, expanded);
+                }
+            }
+            lowLevelExpanded += expanded;
+        });
+
+        result.nodes += static_cast<int>(batch.size());
+        for (size_t k = 0; k < batch.size(); ++k) {
+            if (conflicts[k].a < 0) {
+                if (!solution || batch[k]->cost < solution->cost) solution = batch[k];
+                continue;
+            }
+            for (int side = 0; side < 2; ++side) {
+                if (!children[k * 2 + side]) continue;
+                children[k * 2 + side]->id = nextId++;
+                open.push(std::move(children[k * 2 + side]));
+            }
+        }
+    }
+
+    result.lowLevelExpanded = lowLevelExpanded;
+    if (!solution) return result;
+    result.paths.resize(count);
+    for (int i = 0; i < count; ++i) {
+        for (int cell : *solution->paths[i]) result.paths[i].push_back(m_graph.cell(cell));
+    }
+    result.costs = solution->costs;
+    result.totalCost = solution->cost;
+    return result;
+}
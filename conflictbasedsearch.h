@@ -0,0 +1,98 @@
+#ifndef CONFLICTBASEDSEARCH_H
+#define CONFLICTBASEDSEARCH_H
+
+#include "cooperativepathfinder.h"
+#include "gridgraph.h"
+#include "gridmodel.h"
+#include "reservationtable.h"
+#include "spacetimesearch.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Optimal collision free paths for a small group of agents (conflict based search).
+// Every agent first plans alone. The constraint tree then repeatedly takes its cheapest node, finds the first time two
+// agents collide (same cell, or swapping places) and splits it in two: one child forbids that cell/move for the first
+// agent, the other for the second, and only the constrained agent replans (SpaceTimeSearch with its constraints in a
+// ReservationTable). The first conflict free node is optimal for the sum of the agents' costs (same costs as
+// CooperativePathfinder).
+// Tree nodes are expanded in batches of one node per worker thread on the WorkerPool. The search contexts (node
+// storage, constraint table) are kept between low level calls and between solve() calls instead of being reallocated.
+class ConflictBasedSearch {
+public:
+    using Agent = CooperativePathfinder::Agent;
+
+    // give up after expanding this many constraint tree nodes
+    static constexpr int kDefaultMaxNodes = 20000;
+
+    struct Result {
+        // position of every agent at every time step, from time 0 until it stays on its goal (empty if no solution)
+        std::vector<std::vector<std::pair<uint8_t, uint8_t>>> paths;
+        std::vector<double> costs;        // per agent
+        double totalCost = -1;            // sum of all costs, -1 if there is no solution (or maxNodes ran out)
+        int nodes = 0;                    // constraint tree nodes expanded
+        long long lowLevelExpanded = 0;   // (cell, time) states expanded by all agent searches together
+    };
+
+    explicit ConflictBasedSearch(const GridModel& model);
+
+    // copies one edited cell from the model
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // throws std::out_of_range for cells outside the grid
+    Result solve(const std::vector<Agent>& agents, int maxNodes = kDefaultMaxNodes);
+
+private:
+    // agent may not be on cell at time (to == -1), or may not move from cell to to between time and time + 1
+    struct Constraint {
+        int agent = -1;
+        int cell = -1;
+        int to = -1;
+        int time = -1;
+    };
+
+    // constraint tree node: its own constraint plus all constraints of its ancestors, and the current plan
+    struct TreeNode {
+        std::shared_ptr<const TreeNode> parent;
+        Constraint constraint;
+        std::vector<std::shared_ptr<const std::vector<int>>> paths;  // unchanged paths are shared with the parent
+        std::vector<double> costs;
+        double cost = 0.0;
+        int id = 0;
+    };
+
+    // two agents colliding at time: both on cell (to == -1), or a moving cell -> to while b moves to -> cell
+    struct Conflict {
+        int a = -1;
+        int b = -1;
+        int cell = -1;
+        int to = -1;
+        int time = -1;
+    };
+
+    // everything one low level search needs, reused from call to call
+    struct SearchContext {
+        explicit SearchContext(const GridGraph& graph) : search(graph), constraints(graph.size()) {}
+        SpaceTimeSearch search;
+        ReservationTable constraints;
+        std::vector<int> cells;
+    };
+
+    // first collision in the node's plan (a == -1 if there is none)
+    Conflict firstConflict(const TreeNode& node) const;
+
+    // child of parent with one more constraint, nullptr if the constrained agent has no path anymore
+    std::shared_ptr<TreeNode> child(const std::shared_ptr<const TreeNode>& parent, const Constraint& constraint, const std::vector<int>& starts,
+                                    const std::vector<int>& goals, std::vector<GoalDistance>& distances, long long& expanded);
+
+    // borrow a context (creating one if all are in use) and give it back
+    std::unique_ptr<SearchContext> takeContext();
+    void returnContext(std::unique_ptr<SearchContext> context);
+
+    GridGraph m_graph;
+    std::vector<std::unique_ptr<SearchContext>> m_contexts;
+    std::mutex m_contextMutex;
+};
+
+#endif // CONFLICTBASEDSEARCH_H
@@ -0,0 +1,423 @@
+#include "contractionhierarchy.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// witness searches give up after settling this many cells. giving up early only means an extra (unneeded but
+// harmless) shortcut, while searching further costs preprocessing time.
+constexpr int kWitnessSettleLimit = 500;
+
+// an edge while the graph is being contracted (to = other end, middle = skipped cell or -1)
+struct Arc {
+    int to;
+    double weight;
+    int middle;
+};
+
+// a shortcut that contracting a cell requires
+struct Shortcut {
+    int from;
+    int to;
+    double weight;
+};
+
+using MinQueue = std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>>;
+
+// scratch buffers for witness searches, one per parallel chunk so threads never share them
+struct WitnessScratch {
+    std::vector<double> dist;
+    std::vector<int> touched;
+    MinQueue queue;
+
+    explicit WitnessScratch(int n) : dist(n, kInfinity) {}
+
+    void reset() {
+        for (int v : touched) dist[v] = kInfinity;
+        touched.clear();
+        queue = {};
+    }
+};
+
+// scratch buffers for queries. thread_local so queries from several threads dont need a lock, and so nothing
+// has to be allocated or cleared in full for every query (only the touched cells are reset).
+struct QueryScratch {
+    std::vector<double> forwardDist;
+    std::vector<double> backwardDist;
+    std::vector<int> forwardParent;
+    std::vector<int> backwardParent;
+    std::vector<int> touched;
+
+    void prepare(int n) {
+        if (static_cast<int>(forwardDist.size()) < n) {
+            forwardDist.assign(n, kInfinity);
+            backwardDist.assign(n, kInfinity);
+            forwardParent.assign(n, -1);
+            backwardParent.assign(n, -1);
+        }
+    }
+
+    void reset() {
+        for (int v : touched) {
+            forwardDist[v] = backwardDist[v] = kInfinity;
+            forwardParent[v] = backwardParent[v] = -1;
+        }
+        touched.clear();
+    }
+};
+
+thread_local QueryScratch t_queryScratch;
+
+// works out which shortcuts contracting v would need, given the current (partly contracted) graph.
+// for every pair in-neighbour u -> v -> out-neighbour x a shortcut u -> x is only needed if a small Dijkstra from u
+// that avoids v cant find a path to x that is at least as cheap (a "witness").
+void findShortcuts(int v, const std::vector<std::vector<Arc>>& out, const std::vector<std::vector<Arc>>& in,
+                   WitnessScratch& scratch, std::vector<Shortcut>& shortcuts)
+{
+    shortcuts.clear();
+    for (const Arc& inArc : in[v]) {
+        const int u = inArc.to;
+
+        // longest path via v we have to beat, the witness search can stop beyond it. nothing to do if u is v's only
+        // neighbour (the limit itself can be anything, so it cant tell)
+        double limit = -1.0;
+        bool hasTarget = false;
+        for (const Arc& outArc : out[v]) {
+            if (outArc.to == u) continue;
+            limit = std::max(limit, inArc.weight + outArc.weight);
+            hasTarget = true;
+        }
+        if (!hasTarget) continue;
+
+        // Dijkstra from u that never enters v
+        scratch.dist[u] = 0.0;
+        scratch.touched.push_back(u);
+        scratch.queue.push({0.0, u});
+        int settled = 0;
+        while (!scratch.queue.empty() && settled < kWitnessSettleLimit) {
+            const auto [d, current] = scratch.queue.top();
+            scratch.queue.pop();
+            if (d > scratch.dist[current]) continue;
+            if (d > limit) break;
+            ++settled;
+            for (const Arc& arc : out[current]) {
+                if (arc.to == v) continue;
+                const double newDist = d + arc.weight;
+                if (newDist < scratch.dist[arc.to]) {
+                    if (scratch.dist[arc.to] == kInfinity) scratch.touched.push_back(arc.to);
+                    scratch.dist[arc.to] = newDist;
+                    scratch.queue.push({newDist, arc.to});
+                }
+            }
+        }
+
+        // every out-neighbour without a witness needs a shortcut
+        for (const Arc& outArc : out[v]) {
+            if (outArc.to == u) continue;
+            const double viaV = inArc.weight + outArc.weight;
+            if (scratch.dist[outArc.to] > viaV) shortcuts.push_back({u, outArc.to, viaV});
+        }
+        scratch.reset();
+    }
+}
+
+// adds edge from -> to, or makes an existing one cheaper
+void addOrImprove(std::vector<std::vector<Arc>>& out, std::vector<std::vector<Arc>>& in, int from, int to, double weight, int middle)
+{
+    for (Arc& arc : out[from]) {
+        if (arc.to != to) continue;
+        if (arc.weight <= weight) return;
+        arc.weight = weight;
+        arc.middle = middle;
+        for (Arc& back : in[to]) {
+            if (back.to == from) {
+                back.weight = weight;
+                back.middle = middle;
+            }
+        }
+        return;
+    }
+    out[from].push_back({to, weight, middle});
+    in[to].push_back({from, weight, middle});
+}
+
+// removes every arc that points at v from the list
+void removeArcsTo(std::vector<Arc>& arcs, int v)
+{
+    arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [v](const Arc& arc) { return arc.to == v; }), arcs.end());
+}
+}
+
+ContractionHierarchy::ContractionHierarchy(const GridModel& model, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const int n = m_graph.size();
+    WorkerPool& pool = WorkerPool::instance();
+
+    // start with the plain grid: an arc to every passable neighbour, weighted by the neighbour's terrain cost
+    std::vector<std::vector<Arc>> out(n), in(n);
+    std::vector<int> remaining;
+    for (int v = 0; v < n; ++v) {
+        if (!m_graph.passable(v)) continue;
+        remaining.push_back(v);
+        m_graph.forEachNeighbour(v, [&](int nb, int) {
+            out[v].push_back({nb, m_graph.cost(nb), -1});
+            in[nb].push_back({v, m_graph.cost(nb), -1});
+        });
+    }
+
+    // importance of a cell: shortcuts it would add minus edges it removes, plus how many neighbours are already gone
+    // (spreads the contraction evenly over the map instead of eating away one region at a time)
+    std::vector<int> priority(n, 0);
+    std::vector<int> contractedNeighbours(n, 0);
+    auto updatePriorities = [&](const std::vector<int>& cells) {
+        pool.parallelFor(static_cast<int>(cells.size()), [&](int begin, int end) {
+            WitnessScratch scratch(n);
+            std::vector<Shortcut> shortcuts;
+            for (int i = begin; i < end; ++i) {
+                const int v = cells[i];
+                findShortcuts(v, out, in, scratch, shortcuts);
+                priority[v] = static_cast<int>(shortcuts.size()) - static_cast<int>(out[v].size() + in[v].size()) + contractedNeighbours[v];
+            }
+        });
+    };
+    updatePriorities(remaining);
+
+    // (priority, cell) as one comparable number so ties are broken by cell index
+    auto key = [&priority, n](int v) { return static_cast<int64_t>(priority[v]) * n + v; };
+
+    std::vector<int64_t> neighbourhoodMin(n);
+    std::vector<std::vector<Arc>> upForward(n), upBackward(n);
+    m_rank.assign(n, -1);
+    int nextRank = 0;
+
+    while (!remaining.empty()) {
+        // (1) pick every cell that is the least important within 2 steps. no two picked cells share a neighbour,
+        //     so their contractions cant affect each other's witness searches and can run at the same time.
+        pool.parallelFor(static_cast<int>(remaining.size()), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const int v = remaining[i];
+                int64_t best = key(v);
+                for (const Arc& arc : out[v]) best = std::min(best, key(arc.to));
+                for (const Arc& arc : in[v]) best = std::min(best, key(arc.to));
+                neighbourhoodMin[v] = best;
+            }
+        });
+        std::vector<int> selected;
+        for (int v : remaining) {
+            bool isMinimum = neighbourhoodMin[v] == key(v);
+            for (const Arc& arc : out[v]) isMinimum = isMinimum && neighbourhoodMin[arc.to] >= key(v);
+            for (const Arc& arc : in[v]) isMinimum = isMinimum && neighbourhoodMin[arc.to] >= key(v);
+            if (isMinimum) selected.push_back(v);
+        }
+
+        // (2) find the shortcuts of all selected cells in parallel (only reads the graph)
+        std::vector<std::vector<Shortcut>> shortcuts(selected.size());
+        pool.parallelFor(static_cast<int>(selected.size()), [&](int begin, int end) {
+            WitnessScratch scratch(n);
+            for (int i = begin; i < end; ++i) {
+                findShortcuts(selected[i], out, in, scratch, shortcuts[i]);
+            }
+        });
+
+        // (3) apply the contractions one after another (changes the graph, so not in parallel)
+        std::vector<int> touchedNeighbours;
+        for (size_t i = 0; i < selected.size(); ++i) {
+            const int v = selected[i];
+            m_rank[v] = nextRank++;
+
+            // every edge v still has goes to a cell that is contracted later (= ranked higher), so these are
+            // exactly v's upward edges in the finished hierarchy
+            upForward[v] = out[v];
+            upBackward[v] = in[v];
+
+            // take v out of the remaining graph
+            for (const Arc& arc : out[v]) {
+                removeArcsTo(in[arc.to], v);
+                ++contractedNeighbours[arc.to];
+                touchedNeighbours.push_back(arc.to);
+            }
+            for (const Arc& arc : in[v]) {
+                removeArcsTo(out[arc.to], v);
+                ++contractedNeighbours[arc.to];
+                touchedNeighbours.push_back(arc.to);
+            }
+            std::vector<Arc>().swap(out[v]);
+            std::vector<Arc>().swap(in[v]);
+
+            // keep the distances between v's neighbours correct
+            for (const Shortcut& shortcut : shortcuts[i]) {
+                addOrImprove(out, in, shortcut.from, shortcut.to, shortcut.weight, v);
+            }
+        }
+
+        // (4) only the neighbours of contracted cells can change importance
+        std::sort(touchedNeighbours.begin(), touchedNeighbours.end());
+        touchedNeighbours.erase(std::unique(touchedNeighbours.begin(), touchedNeighbours.end()), touchedNeighbours.end());
+        updatePriorities(touchedNeighbours);
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [this](int v) { return m_rank[v] >= 0; }), remaining.end());
+    }
+
+    // flatten the per cell edge lists into the compact query layout
+    auto flatten = [n](std::vector<std::vector<Arc>>& lists, std::vector<int>& offsets, std::vector<Edge>& edges) {
+        offsets.assign(n + 1, 0);
+        for (int v = 0; v < n; ++v) offsets[v + 1] = offsets[v] + static_cast<int>(lists[v].size());
+        edges.reserve(offsets[n]);
+        for (auto& list : lists) {
+            for (const Arc& arc : list) edges.push_back({arc.to, arc.weight, arc.middle});
+            std::vector<Arc>().swap(list);
+        }
+    };
+    flatten(upForward, m_forwardOffsets, m_forward);
+    flatten(upBackward, m_backwardOffsets, m_backward);
+
+    m_stats.nodes = nextRank;
+    m_stats.edges = m_forward.size() + m_backward.size();
+    for (const Edge& edge : m_forward) m_stats.shortcuts += edge.middle >= 0;
+    for (const Edge& edge : m_backward) m_stats.shortcuts += edge.middle >= 0;
+    m_stats.bytes = sizeof(*this)
+                    + static_cast<size_t>(n) * (sizeof(double) + sizeof(int))
+                    + (m_forwardOffsets.size() + m_backwardOffsets.size()) * sizeof(int)
+                    + m_stats.edges * sizeof(Edge);
+    m_stats.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int ContractionHierarchy::search(int s, int t, double& bestDistance, std::vector<int>* forwardParent, std::vector<int>* backwardParent) const
+{
+    QueryScratch& scratch = t_queryScratch;
+    scratch.prepare(m_graph.size());
+
+    MinQueue forwardQueue, backwardQueue;
+    scratch.forwardDist[s] = 0.0;
+    scratch.backwardDist[t] = 0.0;
+    scratch.touched.push_back(s);
+    scratch.touched.push_back(t);
+    forwardQueue.push({0.0, s});
+    backwardQueue.push({0.0, t});
+
+    bestDistance = kInfinity;
+    int meeting = -1;
+    if (s == t) {
+        bestDistance = 0.0;
+        meeting = s;
+    }
+
+    // one step of either search: settle the cheapest cell, check if it connects to the other side, relax upward edges
+    auto step = [&](MinQueue& queue, std::vector<double>& dist, std::vector<int>& parent, const std::vector<double>& otherDist,
+                    const std::vector<int>& offsets, const std::vector<Edge>& edges) {
+        const auto [d, v] = queue.top();
+        queue.pop();
+        if (d > dist[v]) return;
+        if (otherDist[v] != kInfinity && d + otherDist[v] < bestDistance) {
+            bestDistance = d + otherDist[v];
+            meeting = v;
+        }
+        for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+            const Edge& edge = edges[e];
+            const double newDist = d + edge.weight;
+            if (newDist < dist[edge.other]) {
+                if (scratch.forwardDist[edge.other] == kInfinity && scratch.backwardDist[edge.other] == kInfinity) scratch.touched.push_back(edge.other);
+                dist[edge.other] = newDist;
+                parent[edge.other] = v;
+                queue.push({newDist, edge.other});
+            }
+        }
+    };
+
+    // alternate between the two searches. a side can stop once its cheapest queued cell is already more expensive
+    // than the best connection found (unlike plain bidirectional Dijkstra, both sides have to get there)
+    while (true) {
+        const bool forwardActive = !forwardQueue.empty() && forwardQueue.top().first < bestDistance;
+        const bool backwardActive = !backwardQueue.empty() && backwardQueue.top().first < bestDistance;
+        if (!forwardActive && !backwardActive) break;
+        if (forwardActive) step(forwardQueue, scratch.forwardDist, scratch.forwardParent, scratch.backwardDist, m_forwardOffsets, m_forward);
+        if (backwardActive) step(backwardQueue, scratch.backwardDist, scratch.backwardParent, scratch.forwardDist, m_backwardOffsets, m_backward);
+    }
+
+    // hand the search trees out before the scratch buffers are reset
+    if (meeting >= 0 && forwardParent && backwardParent) {
+        for (int v = meeting; v != s; v = scratch.forwardParent[v]) forwardParent->push_back(scratch.forwardParent[v]);
+        for (int v = meeting; v != t; v = scratch.backwardParent[v]) backwardParent->push_back(scratch.backwardParent[v]);
+    }
+    scratch.reset();
+    return meeting;
+}
+
+double ContractionHierarchy::distance(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return -1;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (m_rank[s] < 0 || m_rank[t] < 0) return -1;
+
+    double best;
+    return search(s, t, best, nullptr, nullptr) >= 0 ? best : -1;
+}
+
+Pathfinder::PathResult ContractionHierarchy::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return result;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (m_rank[s] < 0 || m_rank[t] < 0) return result;
+
+    // forwardChain = cells from the meeting cell back to s, backwardChain = cells from the meeting cell on to t
+    std::vector<int> forwardChain, backwardChain;
+    double best;
+    const int meeting = search(s, t, best, &forwardChain, &backwardChain);
+    if (meeting < 0) return result;
+
+    // hierarchy level path: s ... meeting ... t
+    std::vector<int> chain(forwardChain.rbegin(), forwardChain.rend());
+    chain.push_back(meeting);
+    chain.insert(chain.end(), backwardChain.begin(), backwardChain.end());
+
+    // replace every edge by the grid cells it stands for
+    std::vector<int> cells {chain.front()};
+    for (size_t i = 0; i + 1 < chain.size(); ++i) {
+        unpackEdge(chain[i], chain[i + 1], cells);
+    }
+
+    for (int cell : cells) result.path.push_back(m_graph.cell(cell));
+    result.totalCost = best;
+    return result;
+}
+
+const ContractionHierarchy::Edge* ContractionHierarchy::findEdge(int from, int to) const
+{
+    // an edge lives at its lower ranked end: as a forward edge if it points up, as a backward edge if it points down
+    if (m_rank[from] < m_rank[to]) {
+        for (int e = m_forwardOffsets[from]; e < m_forwardOffsets[from + 1]; ++e) {
+            if (m_forward[e].other == to) return &m_forward[e];
+        }
+    } else {
+        for (int e = m_backwardOffsets[to]; e < m_backwardOffsets[to + 1]; ++e) {
+            if (m_backward[e].other == from) return &m_backward[e];
+        }
+    }
+    return nullptr;
+}
+
+void ContractionHierarchy::unpackEdge(int from, int to, std::vector<int>& path) const
+{
+    const Edge* edge = findEdge(from, to);
+    // a plain grid step (or a missing edge, which cant happen in a finished hierarchy)
+    if (!edge || edge->middle < 0) {
+        path.push_back(to);
+        return;
+    }
+    // a shortcut stands for from -> middle -> to, and both halves may be shortcuts again
+    unpackEdge(from, edge->middle, path);
+    unpackEdge(edge->middle, to, path);
+}
@@ -0,0 +1,77 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <vector>
+
+// Contraction Hierarchy (CH) over the grid graph.
+// Preprocessing removes ("contracts") the cells one at a time from least to most important. Whenever removing a cell
+// would make a shortest path between two of its neighbours longer, a "shortcut" edge is added between them that
+// remembers the removed cell in the middle. Afterwards every cell has a rank (the order it was removed in).
+// A query then only ever climbs upwards in rank: a Dijkstra forward from the start over edges to higher ranks and
+// one backward from the goal, meeting at the most important cell of the path. These searches touch only a tiny part
+// of the grid, which is what turns millisecond A* queries into microsecond ones on maps that dont change.
+// Shortcuts are unpacked recursively back into the individual cells so the path can be drawn in the GridView.
+class ContractionHierarchy {
+public:
+    // size / speed information about the last build
+    struct Stats {
+        int nodes = 0;                 // passable cells
+        size_t edges = 0;              // upward edges stored (original + shortcuts)
+        size_t shortcuts = 0;          // how many of those are shortcuts
+        size_t bytes = 0;              // memory used by the hierarchy
+        double buildMilliseconds = 0;  // preprocessing time
+    };
+
+    // builds the hierarchy for the current grid. contraction runs in rounds on the WorkerPool: every round picks a set
+    // of cells that are far enough apart not to influence each other and contracts all of them in parallel.
+    // the shortcuts only hold for the costs of one profile.
+    explicit ContractionHierarchy(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // cost of the cheapest path, -1 if there is none
+    double distance(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // cheapest path with every shortcut unpacked back into cells, same format as Pathfinder::findPath()
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // version of the GridModel the hierarchy was built from (rebuild when GridModel::version() differs)
+    std::uint64_t version() const noexcept { return m_graph.version(); }
+
+    const Stats& stats() const noexcept { return m_stats; }
+
+private:
+    // an edge of the finished hierarchy. "other" is the target for upward forward edges and the source for upward
+    // backward edges. middle is the contracted cell a shortcut skips over (-1 for an edge between two grid neighbours).
+    struct Edge {
+        int other;
+        double weight;
+        int middle;
+    };
+
+    // upward searches from both ends. returns the meeting cell (or -1) and fills the parent arrays for unpacking.
+    int search(int s, int t, double& bestDistance, std::vector<int>* forwardParent, std::vector<int>* backwardParent) const;
+
+    // appends the cells of edge from -> to (without "from" itself) to path, expanding shortcuts recursively
+    void unpackEdge(int from, int to, std::vector<int>& path) const;
+
+    // finds the upward edge from -> to, which is stored at whichever of the two cells has the lower rank
+    const Edge* findEdge(int from, int to) const;
+
+    GridGraph m_graph;
+    Stats m_stats;
+
+    // rank of every cell (order of contraction, higher = more important), -1 for walls
+    std::vector<int> m_rank;
+
+    // edges to higher ranked cells, stored in one flat array per direction (CSR layout):
+    // forward edges of cell v are m_forward[m_forwardOffsets[v] .. m_forwardOffsets[v + 1]) and lead from v upwards,
+    // backward edges lead from a higher ranked cell down into v (they are walked in reverse by the backward search)
+    std::vector<int> m_forwardOffsets;
+    std::vector<Edge> m_forward;
+    std::vector<int> m_backwardOffsets;
+    std::vector<Edge> m_backward;
+};
+
+#endif // CONTRACTIONHIERARCHY_H
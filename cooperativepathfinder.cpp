@@ -0,0 +1,163 @@
+#include "cooperativepathfinder.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+CooperativePathfinder::CooperativePathfinder(const GridModel& model)
+    : m_graph(model)
+    , m_search(m_graph)
+{
+}
+
+void CooperativePathfinder::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    m_graph.refreshCell(model, row, col);
+}
+
+std::vector<int> CooperativePathfinder::startCells(const std::vector<Agent>& agents) const
+{
+    std::vector<int> cells;
+    for (const Agent& agent : agents) {
+        if (agent.start.first >= m_graph.rowCount() || agent.start.second >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+        cells.push_back(m_graph.index(agent.start));
+    }
+    return cells;
+}
+
+std::vector<int> CooperativePathfinder::goalCells(const std::vector<Agent>& agents) const
+{
+    std::vector<int> cells;
+    for (const Agent& agent : agents) {
+        if (agent.goal.first >= m_graph.rowCount() || agent.goal.second >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+        cells.push_back(m_graph.index(agent.goal));
+    }
+    return cells;
+}
+
+std::vector<GoalDistance> CooperativePathfinder::goalDistances(const std::vector<int>& starts, const std::vector<int>& goals, std::vector<int>& slotOf) const
+{
+    // agents sharing a goal share the table (aimed at the first of them)
+    std::vector<GoalDistance> distances;
+    std::unordered_map<int, int> slotOfGoal;
+    slotOf.clear();
+    for (size_t i = 0; i < goals.size(); ++i) {
+        const auto [it, inserted] = slotOfGoal.try_emplace(goals[i], static_cast<int>(distances.size()));
+        if (inserted) distances.emplace_back(m_graph, goals[i], starts[i]);
+        slotOf.push_back(it->second);
+    }
+    return distances;
+}
+
+CooperativePathfinder::Result CooperativePathfinder::planAll(const std::vector<Agent>& agents)
+{
+    const std::vector<int> starts = startCells(agents);
+    const std::vector<int> goals = goalCells(agents);
+
+    std::vector<int> slotOf;
+    std::vector<GoalDistance> distances = goalDistances(starts, goals, slotOf);
+
+    Result result;
+    result.paths.resize(agents.size());
+    result.costs.assign(agents.size(), -1);
+    m_reservations.reset(m_graph.size());
+    std::vector<int> cells;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (!m_graph.passable(starts[i]) || !m_graph.passable(goals[i])) continue;
+        const bool found = m_search.search(starts[i], goals[i], 0, 0, m_reservations, distances[slotOf[i]], cells);
+        result.expanded += m_search.lastExpanded();
+        if (!found) continue;
+
+        m_reservations.reservePath(cells, 0, true);
+        double cost = 0.0;
+        for (size_t t = 0; t < cells.size(); ++t) {
+            if (t > 0) cost += SpaceTimeSearch::stepCost(m_graph, cells[t - 1], cells[t], goals[i]);
+            result.paths[i].push_back(m_graph.cell(cells[t]));
+        }
+        result.costs[i] = cost;
+    }
+    return result;
+}
+
+CooperativePathfinder::Result CooperativePathfinder::planWindowed(const std::vector<Agent>& agents, int window, int replanEvery, int maxSteps)
+{
+    const std::vector<int> starts = startCells(agents);
+    const std::vector<int> goals = goalCells(agents);
+    window = std::max(window, 1);
+    replanEvery = std::clamp(replanEvery, 1, window);
+
+    std::vector<int> slotOf;
+    std::vector<GoalDistance> distances = goalDistances(starts, goals, slotOf);
+
+    const int count = static_cast<int>(agents.size());
+    Result result;
+    result.paths.resize(count);
+    result.costs.assign(count, -1);
+
+    // walked cells and the cost paid so far after every step
+    std::vector<std::vector<int>> walked(count);
+    std::vector<std::vector<double>> paid(count);
+    std::vector<char> active(count, 0);
+    for (int i = 0; i < count; ++i) {
+        active[i] = m_graph.passable(starts[i]) && m_graph.passable(goals[i]);
+        walked[i] = {starts[i]};
+        paid[i] = {0.0};
+    }
+
+    std::vector<std::vector<int>> plans(count);
+    std::vector<char> waits(count, 0);
+    m_reservations.reset(m_graph.size());
+    for (int now = 0, round = 0; now < maxSteps; now += replanEvery, ++round) {
+        bool arrived = true;
+        for (int i = 0; i < count; ++i) arrived = arrived && (!active[i] || walked[i].back() == goals[i]);
+        if (arrived) break;
+
+        // a new window: only the plans of this round are reserved. the order rotates so no agent is always last.
+        // an agent whose search fails has to wait where it is, but agents planned before it may already pass through
+        // its cell. so it is added to the waiting agents, whose cells are reserved before anyone plans, and the round
+        // starts over. the waiting agents stand on different cells, so at worst everyone waits and nothing collides
+        std::fill(waits.begin(), waits.end(), 0);
+        while (true) {
+            m_reservations.clear();
+            for (int i = 0; i < count; ++i) {
+                if (!active[i] || !waits[i]) continue;
+                plans[i].assign(window + 1, walked[i].back());
+                m_reservations.reservePath(plans[i], now, false);
+            }
+
+            int failed = -1;
+            for (int k = 0; k < count && failed < 0; ++k) {
+                const int i = (k + round) % count;
+                if (!active[i] || waits[i]) continue;
+                const bool found = m_search.search(walked[i].back(), goals[i], now, window, m_reservations, distances[slotOf[i]], plans[i]);
+                result.expanded += m_search.lastExpanded();
+                if (found) {
+                    m_reservations.reservePath(plans[i], now, false);
+                } else {
+                    failed = i;
+                }
+            }
+            if (failed < 0) break;
+            waits[failed] = 1;
+        }
+
+        const int steps = std::min(replanEvery, maxSteps - now);
+        for (int i = 0; i < count; ++i) {
+            if (!active[i]) continue;
+            for (int s = 1; s <= steps; ++s) {
+                paid[i].push_back(paid[i].back() + SpaceTimeSearch::stepCost(m_graph, walked[i].back(), plans[i][s], goals[i]));
+                walked[i].push_back(plans[i][s]);
+            }
+        }
+    }
+
+    // cut every walk off where the agent reached its goal for the last time
+    for (int i = 0; i < count; ++i) {
+        if (!active[i] || walked[i].back() != goals[i]) continue;
+        size_t arrival = walked[i].size() - 1;
+        while (arrival > 0 && walked[i][arrival - 1] == goals[i]) --arrival;
+        for (size_t t = 0; t <= arrival; ++t) result.paths[i].push_back(m_graph.cell(walked[i][t]));
+        result.costs[i] = paid[i][arrival];
+    }
+    return result;
+}
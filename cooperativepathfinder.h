@@ -0,0 +1,60 @@
+#ifndef COOPERATIVEPATHFINDER_H
+#define COOPERATIVEPATHFINDER_H
+
+#include "gridgraph.h"
+#include "gridmodel.h"
+#include "reservationtable.h"
+#include "spacetimesearch.h"
+#include <cstdint>
+#include <vector>
+
+// Collision free paths for many agents sharing the grid (cooperative A*).
+// Agents plan one after another with a SpaceTimeSearch over (cell, time): cells and moves that earlier agents reserved
+// in the ReservationTable are off limits. The heuristic is the exact cost to the goal ignoring the other agents
+// (GoalDistance, one per distinct goal).
+// The windowed variant only looks (and reserves) window time steps ahead, lets every agent walk replanEvery steps of
+// that and then plans again, so agents that plan early dont get to block everyone else until they arrive.
+class CooperativePathfinder {
+public:
+    struct Agent {
+        std::pair<uint8_t, uint8_t> start;
+        std::pair<uint8_t, uint8_t> goal;
+    };
+
+    struct Result {
+        // position of every agent at every time step, from time 0 until it stays on its goal (empty if it failed)
+        std::vector<std::vector<std::pair<uint8_t, uint8_t>>> paths;
+        std::vector<double> costs;  // per agent, -1 if it has no path (or didnt arrive within maxSteps)
+        int expanded = 0;           // (cell, time) states expanded by all searches together
+    };
+
+    explicit CooperativePathfinder(const GridModel& model);
+
+    // copies one edited cell from the model
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // cooperative A*: agents plan in the given order, each one around all agents before it, and park on their goal.
+    // an agent without a path reserves nothing (later agents may run through it).
+    // throws std::out_of_range for cells outside the grid
+    Result planAll(const std::vector<Agent>& agents);
+
+    // windowed cooperative A*: every replanEvery steps all agents plan window steps ahead (in rotating order) and walk
+    // the first replanEvery of them, until everyone is on its goal or maxSteps steps have passed. an agent whose
+    // window search fails waits where it is (its cell is reserved first and the others plan again around it), so the
+    // paths never collide. throws std::out_of_range for cells outside the grid
+    Result planWindowed(const std::vector<Agent>& agents, int window, int replanEvery, int maxSteps);
+
+private:
+    // one GoalDistance per distinct goal, and for every agent the index of its goal's entry
+    std::vector<GoalDistance> goalDistances(const std::vector<int>& starts, const std::vector<int>& goals, std::vector<int>& slotOf) const;
+
+    // flat cell indices of the agents' starts and goals
+    std::vector<int> startCells(const std::vector<Agent>& agents) const;
+    std::vector<int> goalCells(const std::vector<Agent>& agents) const;
+
+    GridGraph m_graph;
+    ReservationTable m_reservations;
+    SpaceTimeSearch m_search;
+};
+
+#endif // COOPERATIVEPATHFINDER_H
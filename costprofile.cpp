@@ -0,0 +1,91 @@
+#include "costprofile.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// every profile defined so far, by name
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, CostProfile> profiles {{CostProfile::standard().name(), CostProfile::standard()}};
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+} // namespace
+
+CostProfile::CostProfile() : CostProfile("standard", 1.0, 2.0, 0.5) {}
+
+CostProfile::CostProfile(std::string name, double normal, double rough, double boost)
+    : m_name(std::move(name))
+{
+    // any negative cost means impassable, store them all as -1 like walls
+    auto clean = [](double cost) {
+        if (cost == 0.0 || std::isnan(cost)) throw std::invalid_argument("Terrain costs must be positive, or negative for impassable");
+        return cost < 0 ? -1.0 : cost;
+    };
+    m_costs[GridModel::Normal] = clean(normal);
+    m_costs[GridModel::Wall] = -1.0;
+    m_costs[GridModel::Rough] = clean(rough);
+    m_costs[GridModel::Boost] = clean(boost);
+    m_costs[GridModel::Start] = clean(normal);
+    m_costs[GridModel::Goal] = clean(normal);
+
+    double minCost = std::numeric_limits<double>::infinity();
+    for (double cost : m_costs) {
+        if (cost >= 0) minCost = std::min(minCost, cost);
+    }
+    // a profile that cant enter anything has no paths at all, keep the default so heuristics stay finite
+    if (minCost != std::numeric_limits<double>::infinity()) m_minCost = minCost;
+}
+
+const CostProfile& CostProfile::standard()
+{
+    static const CostProfile profile;
+    return profile;
+}
+
+void CostProfile::define(const CostProfile& profile)
+{
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.profiles.insert_or_assign(profile.name(), profile);
+}
+
+CostProfile CostProfile::named(const std::string& name)
+{
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    const auto it = shared.profiles.find(name);
+    if (it == shared.profiles.end()) throw std::out_of_range("Unknown cost profile: " + name);
+    return it->second;
+}
+
+std::uint64_t CostProfile::fingerprint() const noexcept
+{
+    // FNV-1a hash over the bytes of the costs, like GridGraph::fingerprint()
+    std::uint64_t hash = 1469598103934665603ull;
+    const auto* p = reinterpret_cast<const unsigned char*>(m_costs.data());
+    for (size_t i = 0; i < m_costs.size() * sizeof(double); ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::vector<std::string> CostProfile::names()
+{
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    std::vector<std::string> result;
+    for (const auto& [name, profile] : shared.profiles) result.push_back(name);
+    return result;
+}
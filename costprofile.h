@@ -0,0 +1,60 @@
+#ifndef COSTPROFILE_H
+#define COSTPROFILE_H
+
+#include "gridmodel.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Movement costs of every terrain type for one kind of agent (a vehicle type), under a name that queries can refer to.
+// All profiles share the one GridModel: a profile only decides what entering each terrain costs, so a tracked vehicle
+// can cross rough ground cheaply while a wheeled one avoids it, without a second copy of the grid.
+// Costs < 0 make a terrain impassable (walls always are), Start and Goal cost the same as Normal. A cost of exactly 0 is
+// refused: the engines rely on every move making progress (path retrieval walks by "remaining cost drops").
+// Pathfinder and the preprocessing engines take a profile next to the model (default: standard()) and keep their cost
+// arrays and caches per profile. The multi agent and time dependent searches use the standard costs.
+class CostProfile {
+public:
+    // the costs Pathfinder always used: Normal 1, Rough 2, Boost 0.5 (named "standard")
+    CostProfile();
+
+    // throws std::invalid_argument for a cost of 0 or NaN
+    CostProfile(std::string name, double normal, double rough, double boost);
+
+    const std::string& name() const noexcept { return m_name; }
+
+    // cost of moving INTO a cell of this type, -1 if this profile cant enter it
+    double cost(GridModel::CellType type) const noexcept { return m_costs[type]; }
+
+    // cheapest passable terrain, heuristics scale their distances by this to stay admissible
+    double minCost() const noexcept { return m_minCost; }
+
+    // true if both profiles give every terrain the same cost (caches built for one are valid for the other)
+    bool sameCosts(const CostProfile& other) const noexcept { return m_costs == other.m_costs; }
+
+    // 64 bit hash of the costs (equal for profiles with the same costs), for keying caches by profile
+    std::uint64_t fingerprint() const noexcept;
+
+    // the standard profile (the one Pathfinder::getCost() describes)
+    static const CostProfile& standard();
+
+    // adds a profile to the shared list, replacing one of the same name. thread safe
+    static void define(const CostProfile& profile);
+
+    // copy of the profile with this name (standard() is always there as "standard").
+    // throws std::out_of_range for unknown names
+    static CostProfile named(const std::string& name);
+
+    // names of every defined profile, sorted
+    static std::vector<std::string> names();
+
+private:
+    std::string m_name;
+
+    // indexed by GridModel::CellType
+    std::array<double, 6> m_costs {};
+    double m_minCost = 1.0;
+};
+
+#endif // COSTPROFILE_H
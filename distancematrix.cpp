@@ -0,0 +1,94 @@
+#include "distancematrix.h"
+#include "gridgraph.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <queue>
+
+DistanceMatrix::DistanceMatrix(const GridModel& model)
+    : m_model(model)
+{
+}
+
+DistanceMatrix::Result DistanceMatrix::compute(const std::vector<std::pair<uint8_t, uint8_t>>& sources,
+                                               const std::vector<std::pair<uint8_t, uint8_t>>& targets) const
+{
+    // cellState() throws std::out_of_range for cells outside of the grid
+    for (const auto& cell : sources) m_model.cellState(cell.first, cell.second);
+    for (const auto& cell : targets) m_model.cellState(cell.first, cell.second);
+
+    Result result;
+    result.sourceCount = static_cast<int>(sources.size());
+    result.targetCount = static_cast<int>(targets.size());
+    result.costs.assign(sources.size() * targets.size(), -1.0f);
+    if (sources.empty() || targets.empty()) return result;
+
+    const GridGraph graph(m_model);
+
+    // targets sharing a cell are settled together, so every distinct cell is only counted once
+    std::vector<int> targetCells;
+    for (const auto& cell : targets) {
+        const int index = graph.index(cell);
+        if (graph.passable(index)) targetCells.push_back(index);
+    }
+    std::sort(targetCells.begin(), targetCells.end());
+    targetCells.erase(std::unique(targetCells.begin(), targetCells.end()), targetCells.end());
+    std::vector<char> isTarget(graph.size(), 0);
+    for (int cell : targetCells) isTarget[cell] = 1;
+
+    std::atomic<long long> settled = 0;
+    WorkerPool::instance().parallelFor(result.sourceCount, [&](int begin, int end) {
+        // scratch buffers shared by all sources of the chunk. dist is only reset where the last run touched it
+        std::vector<double> dist(graph.size(), std::numeric_limits<double>::infinity());
+        std::vector<int> touched;
+        std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+        long long chunkSettled = 0;
+
+        for (int s = begin; s < end; ++s) {
+            const int source = graph.index(sources[s]);
+            if (!graph.passable(source)) continue;
+
+            for (int cell : touched) dist[cell] = std::numeric_limits<double>::infinity();
+            touched.clear();
+            queue = {};
+            dist[source] = 0.0;
+            touched.push_back(source);
+            queue.push({0.0, source});
+
+            size_t remaining = targetCells.size();
+            while (!queue.empty() && remaining > 0) {
+                const auto [d, cell] = queue.top();
+                queue.pop();
+                if (d > dist[cell]) continue;
+                ++chunkSettled;
+                remaining -= isTarget[cell];
+                graph.forEachNeighbour(cell, [&](int next, int) {
+                    const double newDist = d + graph.cost(next);
+                    if (newDist < dist[next]) {
+                        if (dist[next] == std::numeric_limits<double>::infinity()) touched.push_back(next);
+                        dist[next] = newDist;
+                        queue.push({newDist, next});
+                    }
+                });
+            }
+
+            // anything still unsettled was never reached (the search only stops early once every target is settled)
+            float* row = result.costs.data() + static_cast<size_t>(s) * result.targetCount;
+            for (int t = 0; t < result.targetCount; ++t) {
+                const double d = dist[graph.index(targets[t])];
+                if (d != std::numeric_limits<double>::infinity()) row[t] = static_cast<float>(d);
+            }
+        }
+        settled += chunkSettled;
+    });
+
+    result.settled = settled;
+    return result;
+}
+
+std::vector<float> DistanceMatrix::fromSource(const std::pair<uint8_t, uint8_t>& source, const std::vector<std::pair<uint8_t, uint8_t>>& targets) const
+{
+    return compute({source}, targets).costs;
+}
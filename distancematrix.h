@@ -0,0 +1,40 @@
+#ifndef DISTANCEMATRIX_H
+#define DISTANCEMATRIX_H
+
+#include "gridmodel.h"
+#include <cstdint>
+#include <vector>
+
+// Cheapest path costs between every source and every target (S x T), for dispatch style decisions where only the
+// costs matter and not the paths.
+// Instead of S * T calls to findPath() it runs one Dijkstra per source that stops as soon as all targets are settled,
+// and the sources are spread over the WorkerPool. Uses the same move costs as Pathfinder.
+// Reads the model while computing, so it must not be edited during a compute() call.
+class DistanceMatrix {
+public:
+    // row major S x T matrix. costs are stored as float (every cost is a multiple of 0.5, so they stay exact) to keep
+    // big matrices small, -1 marks a target that cant be reached from the source
+    struct Result {
+        int sourceCount = 0;
+        int targetCount = 0;
+        std::vector<float> costs;
+        long long settled = 0;  // cells settled by all Dijkstra runs together
+
+        // cost from source s to target t, -1 if there is no path
+        double at(int source, int target) const { return costs[static_cast<size_t>(source) * targetCount + target]; }
+    };
+
+    explicit DistanceMatrix(const GridModel& model);
+
+    // costs from every source to every target. walls as source or target give -1 entries.
+    // throws std::out_of_range for cells outside the grid
+    Result compute(const std::vector<std::pair<uint8_t, uint8_t>>& sources, const std::vector<std::pair<uint8_t, uint8_t>>& targets) const;
+
+    // costs from a single source to every target
+    std::vector<float> fromSource(const std::pair<uint8_t, uint8_t>& source, const std::vector<std::pair<uint8_t, uint8_t>>& targets) const;
+
+private:
+    const GridModel& m_model;
+};
+
+#endif // DISTANCEMATRIX_H
@@ -0,0 +1,100 @@
+#include "distancetransform.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <cmath>
+
+void DistanceTransform::compute(const GridModel& model)
+{
+    const int rows = model.rowCount();
+    const int cols = model.colCount();
+    std::vector<std::uint8_t> walls(static_cast<size_t>(rows) * cols);
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) walls[row * cols + col] = model.cellState(row, col) == GridModel::Wall;
+    }
+    compute(rows, cols, walls);
+    m_fromModel = true;
+    m_version = model.version();
+}
+
+void DistanceTransform::compute(int rows, int cols, const std::vector<std::uint8_t>& walls)
+{
+    m_rows = rows;
+    m_cols = cols;
+    m_fromModel = false;
+    m_squared.assign(static_cast<size_t>(rows) * cols, 0);
+    if (rows == 0 || cols == 0) return;
+
+    // further than any real distance, marks columns (and maps) without walls
+    const std::int64_t far = static_cast<std::int64_t>(rows) + cols;
+
+    // pass 1: distance to the nearest wall in the same column. columns are handled in strips that are walked row by
+    // row, so every pass reads memory in order. the column distances are kept (not squared) in m_squared for now
+    constexpr int kStrip = 64;
+    WorkerPool::instance().parallelFor((cols + kStrip - 1) / kStrip, [&](int begin, int end) {
+        const int from = begin * kStrip;
+        const int to = std::min(cols, end * kStrip);
+        for (int col = from; col < to; ++col) m_squared[col] = walls[col] ? 0 : far;
+        for (int row = 1; row < rows; ++row) {
+            const size_t base = static_cast<size_t>(row) * cols;
+            for (int col = from; col < to; ++col) {
+                m_squared[base + col] = walls[base + col] ? 0 : std::min(far, m_squared[base - cols + col] + 1);
+            }
+        }
+        for (int row = rows - 2; row >= 0; --row) {
+            const size_t base = static_cast<size_t>(row) * cols;
+            for (int col = from; col < to; ++col) {
+                m_squared[base + col] = std::min(m_squared[base + col], m_squared[base + cols + col] + 1);
+            }
+        }
+    });
+
+    // pass 2: along every row, the lowest of the parabolas (col - q)^2 + column(q)^2 (Felzenszwalb and Huttenlocher)
+    WorkerPool::instance().parallelFor(rows, [&](int begin, int end) {
+        // per chunk scratch: squared column distances, parabola apexes and where each parabola starts to be lowest
+        std::vector<std::int64_t> f(cols);
+        std::vector<int> apex(cols);
+        std::vector<double> from(cols + 1);
+        for (int row = begin; row < end; ++row) {
+            std::int64_t* out = m_squared.data() + static_cast<size_t>(row) * cols;
+            for (int col = 0; col < cols; ++col) f[col] = out[col] * out[col];
+
+            // where the parabolas of q and p (p < q) cross
+            auto cross = [&f](int q, int p) {
+                return static_cast<double>((f[q] + static_cast<std::int64_t>(q) * q) - (f[p] + static_cast<std::int64_t>(p) * p)) / (2.0 * (q - p));
+            };
+
+            int k = 0;
+            apex[0] = 0;
+            from[0] = -std::numeric_limits<double>::infinity();
+            from[1] = std::numeric_limits<double>::infinity();
+            for (int q = 1; q < cols; ++q) {
+                double s = cross(q, apex[k]);
+                while (s <= from[k]) {
+                    --k;
+                    s = cross(q, apex[k]);
+                }
+                ++k;
+                apex[k] = q;
+                from[k] = s;
+                from[k + 1] = std::numeric_limits<double>::infinity();
+            }
+
+            k = 0;
+            for (int col = 0; col < cols; ++col) {
+                while (from[k + 1] < col) ++k;
+                const std::int64_t dx = col - apex[k];
+                out[col] = dx * dx + f[apex[k]];
+            }
+        }
+    });
+
+    // anything at least as far as the marker means there is no wall anywhere
+    const std::int64_t noWall = far * far;
+    if (m_squared.front() >= noWall) std::fill(m_squared.begin(), m_squared.end(), kNoWall);
+}
+
+double DistanceTransform::distance(int row, int col) const noexcept
+{
+    const std::int64_t squared = squaredDistance(row, col);
+    return squared == kNoWall ? std::numeric_limits<double>::infinity() : std::sqrt(static_cast<double>(squared));
+}
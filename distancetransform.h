@@ -0,0 +1,56 @@
+#ifndef DISTANCETRANSFORM_H
+#define DISTANCETRANSFORM_H
+
+#include "gridmodel.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Exact Euclidean distance from every cell to the nearest wall cell (measured between cell centres, 0 on walls).
+// Separable and linear time: first the distance to the nearest wall in the same column (one pass down and one up,
+// strips of columns spread over the WorkerPool), then the lower envelope of the parabolas (x - q)^2 + column(q)^2
+// along every row (rows spread over the WorkerPool).
+// Works on any wall mask, not only on a GridModel, so maps bigger than the editor's grid can be processed too.
+// Used by the GridView overlay and as input for costs that depend on how close a cell is to a wall.
+class DistanceTransform {
+public:
+    // squaredDistance() of every cell when there are no walls at all
+    static constexpr std::int64_t kNoWall = std::numeric_limits<std::int64_t>::max();
+
+    // nothing computed yet
+    DistanceTransform() = default;
+
+    // distances to the walls of the model's current terrain
+    void compute(const GridModel& model);
+
+    // distances for a row major rows x cols mask where non zero entries are walls
+    void compute(int rows, int cols, const std::vector<std::uint8_t>& walls);
+
+    // true if compute(model) was called for the model's current terrain
+    bool isUpToDate(const GridModel& model) const noexcept {
+        return m_fromModel && m_version == model.version() && m_rows == model.rowCount() && m_cols == model.colCount();
+    }
+
+    int rowCount() const noexcept { return m_rows; }
+    int colCount() const noexcept { return m_cols; }
+
+    // squared distance in cells (exact), kNoWall if the map has no walls
+    std::int64_t squaredDistance(int row, int col) const noexcept { return m_squared[static_cast<size_t>(row) * m_cols + col]; }
+
+    // distance in cells, infinity if the map has no walls
+    double distance(int row, int col) const noexcept;
+
+    // row major squared distances of all cells
+    const std::vector<std::int64_t>& squaredDistances() const noexcept { return m_squared; }
+
+private:
+    std::vector<std::int64_t> m_squared;
+    int m_rows = 0;
+    int m_cols = 0;
+
+    // set by compute(model), see isUpToDate()
+    bool m_fromModel = false;
+    std::uint64_t m_version = 0;
+};
+
+#endif // DISTANCETRANSFORM_H
@@ -0,0 +1,146 @@
+#include "dynamicflowfield.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+DynamicFlowField::DynamicFlowField(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    if (goal.first >= model.rowCount() || goal.second >= model.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+    m_goal = m_graph.index(goal);
+    m_g.assign(m_graph.size(), std::numeric_limits<double>::infinity());
+    m_rhs.assign(m_graph.size(), std::numeric_limits<double>::infinity());
+    m_isChanged.assign(m_graph.size(), 0);
+
+    // everything starts unknown, only the goal knows its cost. the first propagation is a plain Dijkstra
+    updateCell(m_goal);
+    propagate();
+}
+
+void DynamicFlowField::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    m_graph.refreshCell(model, row, col);
+    const int cell = m_graph.index(row, col);
+    if (!m_isChanged[cell]) {
+        m_isChanged[cell] = 1;
+        m_changed.push_back(cell);
+    }
+}
+
+void DynamicFlowField::repair()
+{
+    if (m_changed.empty()) return;
+
+    // an edit changes what it costs to enter the cell, which is what its neighbours pay to go through it (and a cell
+    // that became a wall or stopped being one changes its own rhs too)
+    for (int cell : m_changed) {
+        m_isChanged[cell] = 0;
+        updateCell(cell);
+        for (int direction = 0; direction < 4; ++direction) {
+            const int nr = cell / m_graph.colCount() + GridGraph::dr[direction];
+            const int nc = cell % m_graph.colCount() + GridGraph::dc[direction];
+            if (nr < 0 || nr >= m_graph.rowCount() || nc < 0 || nc >= m_graph.colCount()) continue;
+            updateCell(nr * m_graph.colCount() + nc);
+        }
+    }
+    m_changed.clear();
+    propagate();
+}
+
+double DynamicFlowField::bestNeighbour(int cell, int& move) const
+{
+    double best = std::numeric_limits<double>::infinity();
+    move = -1;
+    m_graph.forEachNeighbour(cell, [&](int nb, int direction) {
+        const double cost = m_graph.cost(nb) + m_g[nb];
+        if (cost < best) {
+            best = cost;
+            move = direction;
+        }
+    });
+    return best;
+}
+
+void DynamicFlowField::updateCell(int cell)
+{
+    if (!m_graph.passable(cell)) {
+        m_rhs[cell] = std::numeric_limits<double>::infinity();
+    } else if (cell == m_goal) {
+        m_rhs[cell] = 0.0;
+    } else {
+        int move;
+        m_rhs[cell] = bestNeighbour(cell, move);
+    }
+    if (m_g[cell] != m_rhs[cell]) m_queue.push({std::min(m_g[cell], m_rhs[cell]), cell});
+}
+
+void DynamicFlowField::propagate()
+{
+    m_stats.lastRepairPops = 0;
+    m_stats.lastRepairChanged = 0;
+    while (!m_queue.empty()) {
+        const auto [key, cell] = m_queue.top();
+        m_queue.pop();
+        // consistent by now, or queued again with a different key
+        if (m_g[cell] == m_rhs[cell] || key != std::min(m_g[cell], m_rhs[cell])) continue;
+        ++m_stats.lastRepairPops;
+
+        if (m_g[cell] > m_rhs[cell]) {
+            // lower: the cell got cheaper, take the new cost
+            m_g[cell] = m_rhs[cell];
+            ++m_stats.lastRepairChanged;
+        } else {
+            // raise: the old cost is gone, forget it and let the cell find its new cost like everyone relying on it
+            m_g[cell] = std::numeric_limits<double>::infinity();
+            updateCell(cell);
+        }
+        // neighbours pay this cell's terrain plus its cost to go on from here
+        m_graph.forEachNeighbour(cell, [&](int nb, int) { updateCell(nb); });
+    }
+}
+
+double DynamicFlowField::costToGoal(uint8_t row, uint8_t col)
+{
+    if (row >= m_graph.rowCount() || col >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+    repair();
+    const double cost = m_g[m_graph.index(row, col)];
+    return cost == std::numeric_limits<double>::infinity() ? -1.0 : cost;
+}
+
+int DynamicFlowField::nextMove(uint8_t row, uint8_t col)
+{
+    if (row >= m_graph.rowCount() || col >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+    repair();
+    const int cell = m_graph.index(row, col);
+    if (cell == m_goal || m_g[cell] == std::numeric_limits<double>::infinity()) return -1;
+    int move;
+    bestNeighbour(cell, move);
+    return move;
+}
+
+Pathfinder::PathResult DynamicFlowField::pathFrom(const std::pair<uint8_t, uint8_t>& start)
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+    repair();
+    int cell = m_graph.index(start);
+    if (m_g[cell] == std::numeric_limits<double>::infinity()) return result;
+
+    result.path.push_back(start);
+    while (cell != m_goal) {
+        int move;
+        bestNeighbour(cell, move);
+        cell = m_graph.neighbour(cell, move);
+        result.path.push_back(m_graph.cell(cell));
+    }
+    result.totalCost = m_g[m_graph.index(start)];
+    return result;
+}
+
+DynamicFlowField::Stats DynamicFlowField::stats() const
+{
+    Stats stats = m_stats;
+    stats.pendingChanges = static_cast<int>(m_changed.size());
+    return stats;
+}
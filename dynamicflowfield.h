@@ -0,0 +1,73 @@
+#ifndef DYNAMICFLOWFIELD_H
+#define DYNAMICFLOWFIELD_H
+
+#include "gridgraph.h"
+#include "gridmodel.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Cost-to-goal field for one goal that repairs itself after terrain edits instead of being recomputed.
+// Every cell keeps its cost to the goal (g) and the best cost its neighbours offer right now (rhs). An edit only
+// changes rhs of the edited cell and its neighbours; cells where the two disagree are put in a queue and fixed in
+// order of cost, the usual dynamic shortest path scheme: a cell that got cheaper (lower) takes the new cost and passes
+// it on, a cell that got more expensive (raise) forgets its cost first so everything that relied on it is redone.
+// Cells whose cost doesnt change are never touched, so a repair takes time proportional to the affected region.
+// Edits are collected by cellChanged() and repaired together on the next query (or repair()), so a burst of
+// GridModel::cellUpdated notifications costs one repair.
+class DynamicFlowField {
+public:
+    struct Stats {
+        int pendingChanges = 0;     // edited cells waiting for the next repair
+        int lastRepairPops = 0;     // cells taken from the queue by the last repair (the initial build counts as one)
+        int lastRepairChanged = 0;  // cells that took a new cost to the goal in the last repair
+    };
+
+    // builds the field for goal with the profile's costs. throws std::out_of_range for a goal outside the grid
+    DynamicFlowField(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal, const CostProfile& profile = CostProfile::standard());
+
+    // copies one edited cell from the model, the field is repaired on the next query
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // repairs everything queued by cellChanged()
+    void repair();
+
+    // cost of the cheapest path from (row, col) to the goal, -1 if there is none.
+    // like nextMove() and pathFrom() it throws std::out_of_range for cells outside the grid
+    double costToGoal(uint8_t row, uint8_t col);
+
+    // first move (index into GridGraph::dr/dc) of a cheapest path to the goal, -1 on the goal or without a path
+    int nextMove(uint8_t row, uint8_t col);
+
+    // follows the field from start to the goal, same result format as Pathfinder::findPath()
+    Pathfinder::PathResult pathFrom(const std::pair<uint8_t, uint8_t>& start);
+
+    std::pair<uint8_t, uint8_t> goal() const { return m_graph.cell(m_goal); }
+    Stats stats() const;
+
+private:
+    // recomputes rhs of a cell and queues it if it disagrees with g
+    void updateCell(int cell);
+
+    // cheapest neighbour to move to and the cost of going on from there
+    double bestNeighbour(int cell, int& move) const;
+
+    // processes the queue until every cell is consistent
+    void propagate();
+
+    GridGraph m_graph;
+    int m_goal;
+    std::vector<double> m_g;
+    std::vector<double> m_rhs;
+
+    // {min(g, rhs), cell}, entries are stale if the cell became consistent or its key changed since
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> m_queue;
+
+    std::vector<int> m_changed;
+    std::vector<char> m_isChanged;
+    Stats m_stats;
+};
+
+#endif // DYNAMICFLOWFIELD_H
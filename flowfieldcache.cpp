@@ -0,0 +1,158 @@
+#include "flowfieldcache.h"
+#include "workerpool.h"
+#include <limits>
+#include <stdexcept>
+
+FlowFieldCache::FlowField::FlowField(const GridGraph& graph, int goal)
+    : m_goal(goal)
+{
+    // moves are paid on entering, so the cost of x -> goal is the cost of goal -> x minus x's own terrain plus the
+    // goal's terrain (every path can be walked backwards)
+    std::vector<double> dist;
+    std::vector<std::uint8_t> firstMove;
+    graph.firstMoves(goal, dist, firstMove);
+    auto toGoal = [&](int cell) { return cell == goal ? 0.0 : dist[cell] - graph.cost(cell) + graph.cost(goal); };
+
+    m_codes.assign((graph.size() + 1) / 2, 0);
+    for (int cell = 0; cell < graph.size(); ++cell) {
+        std::uint8_t code = kNoPath;
+        if (cell == goal) {
+            code = kAtGoal;
+        } else if (graph.passable(cell) && dist[cell] != std::numeric_limits<double>::infinity()) {
+            // step to the neighbour that is cheapest to enter and go on from
+            double best = std::numeric_limits<double>::infinity();
+            graph.forEachNeighbour(cell, [&](int nb, int direction) {
+                const double cost = graph.cost(nb) + toGoal(nb);
+                if (cost < best) {
+                    best = cost;
+                    code = static_cast<std::uint8_t>(direction);
+                }
+            });
+        }
+        m_codes[cell >> 1] |= code << ((cell & 1) * 4);
+    }
+}
+
+FlowFieldCache::FlowFieldCache(size_t budgetBytes)
+    : m_state(std::make_shared<State>())
+{
+    m_state->budget = budgetBytes;
+}
+
+FlowFieldCache::Status FlowFieldCache::nextMove(const GridModel& model, const std::pair<uint8_t, uint8_t>& cell, const std::pair<uint8_t, uint8_t>& goal, int& move,
+                                                const CostProfile& profile)
+{
+    move = -1;
+    if (cell.first >= model.rowCount() || cell.second >= model.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+    const auto flowField = field(model, goal, profile);
+    if (!flowField) return Status::Pending;
+
+    const std::uint8_t code = flowField->code(cell.first * model.colCount() + cell.second);
+    if (code == FlowField::kNoPath) return Status::NoPath;
+    if (code != FlowField::kAtGoal) move = code;
+    return Status::Ready;
+}
+
+std::shared_ptr<const FlowFieldCache::FlowField> FlowFieldCache::field(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal,
+                                                                      const CostProfile& profile)
+{
+    if (goal.first >= model.rowCount() || goal.second >= model.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+    const Key key {model.version(), model.rowCount(), model.colCount(), goal.first * model.colCount() + goal.second, profile.fingerprint()};
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        State& state = *m_state;
+        const auto it = state.index.find(key);
+        if (it != state.index.end()) {
+            // most recently used goes to the front
+            state.entries.splice(state.entries.begin(), state.entries, it->second);
+            if (it->second->field) ++state.stats.hits;
+            return it->second->field;
+        }
+
+        // the grid changed: fields of the old grid can never be asked for again (fields of other profiles stay)
+        for (auto entry = state.entries.begin(); entry != state.entries.end();) {
+            if (entry->key.version == key.version && entry->key.rows == key.rows && entry->key.cols == key.cols) {
+                ++entry;
+                continue;
+            }
+            if (entry->field) state.bytes -= entry->field->bytes();
+            state.index.erase(entry->key);
+            entry = state.entries.erase(entry);
+        }
+
+        ++state.stats.misses;
+        state.entries.push_front({key, nullptr});
+        state.index[key] = state.entries.begin();
+    }
+
+    // the snapshot is taken here on the calling thread, so the worker never touches the GridModel
+    GridGraph graph(model, profile);
+    std::shared_ptr<State> state = m_state;
+    WorkerPool::instance().submit([state, key, graph = std::move(graph)]() {
+        std::shared_ptr<const FlowField> flowField;
+        try {
+            flowField = std::make_shared<const FlowField>(graph, key.goal);
+        } catch (...) {
+            // out of memory etc, drop the request so it is tried again next time
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        const auto it = state->index.find(key);
+        // cleared or dropped for a newer grid in the meantime
+        if (it == state->index.end() || it->second->field) return;
+        if (!flowField) {
+            state->entries.erase(it->second);
+            state->index.erase(it);
+            return;
+        }
+        it->second->field = std::move(flowField);
+        state->bytes += it->second->field->bytes();
+        evict(*state);
+    });
+    return nullptr;
+}
+
+void FlowFieldCache::evict(State& state)
+{
+    // walk from the least recently used end, pending entries cost nothing and stay
+    auto entry = state.entries.end();
+    while (state.bytes > state.budget && entry != state.entries.begin()) {
+        --entry;
+        if (!entry->field || entry == state.entries.begin()) continue;
+        state.bytes -= entry->field->bytes();
+        state.index.erase(entry->key);
+        entry = state.entries.erase(entry);
+        ++state.stats.evictions;
+    }
+}
+
+void FlowFieldCache::setBudget(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->budget = budgetBytes;
+    evict(*m_state);
+}
+
+void FlowFieldCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->entries.clear();
+    m_state->index.clear();
+    m_state->bytes = 0;
+}
+
+FlowFieldCache::Stats FlowFieldCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    Stats stats = m_state->stats;
+    for (const Entry& entry : m_state->entries) {
+        if (entry.field) {
+            ++stats.fields;
+        } else {
+            ++stats.pending;
+        }
+    }
+    stats.bytes = m_state->bytes;
+    return stats;
+}
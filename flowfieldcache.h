@@ -0,0 +1,114 @@
+#ifndef FLOWFIELDCACHE_H
+#define FLOWFIELDCACHE_H
+
+#include "gridgraph.h"
+#include "gridmodel.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Flow fields for crowds: for one goal, the first move of a cheapest path from every cell of the grid. Any number of
+// agents heading for that goal just read their next move from the shared field, no searching per agent.
+// Fields are cached by goal, cost profile and grid version (GridModel::version()), so agents of different vehicle
+// types share one cache without mixing up their fields. Within a memory budget: when it is exceeded the
+// least recently used fields are dropped. A missing field is computed in the background on the WorkerPool, agents
+// asking for it in the meantime get Status::Pending (and should just wait a frame).
+// Meant for one grid: fields of older versions are dropped as soon as a newer version is asked for.
+class FlowFieldCache {
+public:
+    static constexpr size_t kDefaultBudgetBytes = 16 * 1024 * 1024;
+
+    // one field, never changed after it is computed so threads can share it without locking
+    class FlowField {
+    public:
+        // 4 bit code per cell: 0-3 is the move (index into GridGraph::dr/dc), then these two
+        static constexpr std::uint8_t kAtGoal = 4;
+        static constexpr std::uint8_t kNoPath = 5;
+
+        explicit FlowField(const GridGraph& graph, int goal);
+
+        std::uint8_t code(int cell) const noexcept { return (m_codes[cell >> 1] >> ((cell & 1) * 4)) & 0xF; }
+        int goal() const noexcept { return m_goal; }
+        size_t bytes() const noexcept { return m_codes.size() + sizeof(*this); }
+
+    private:
+        int m_goal;
+        std::vector<std::uint8_t> m_codes;  // two cells per byte, the even cell in the low half
+    };
+
+    enum class Status {
+        Ready,      // move holds the next step (or -1 if the agent is on the goal)
+        Pending,    // the field is being computed, ask again later
+        NoPath      // the goal cant be reached from this cell
+    };
+
+    struct Stats {
+        int fields = 0;        // ready fields in the cache
+        int pending = 0;       // fields being computed
+        size_t bytes = 0;      // memory used by the ready fields
+        long long hits = 0;
+        long long misses = 0;  // requests that started a computation
+        long long evictions = 0;
+    };
+
+    explicit FlowFieldCache(size_t budgetBytes = kDefaultBudgetBytes);
+
+    // next move (index into GridGraph::dr/dc) for an agent on cell heading for goal.
+    // throws std::out_of_range for cells outside the grid
+    Status nextMove(const GridModel& model, const std::pair<uint8_t, uint8_t>& cell, const std::pair<uint8_t, uint8_t>& goal, int& move,
+                    const CostProfile& profile = CostProfile::standard());
+
+    // the field for goal on the model's current grid, nullptr while it is being computed (which starts it if needed)
+    std::shared_ptr<const FlowField> field(const GridModel& model, const std::pair<uint8_t, uint8_t>& goal,
+                                           const CostProfile& profile = CostProfile::standard());
+
+    // changes the memory budget, dropping fields right away if needed
+    void setBudget(size_t budgetBytes);
+
+    // drops every field (computations still running are thrown away when they finish)
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Key {
+        std::uint64_t version;
+        int rows;
+        int cols;
+        int goal;
+        std::uint64_t profile;  // CostProfile::fingerprint()
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const noexcept {
+            return std::hash<std::uint64_t>()((key.version * 0x9E3779B97F4A7C15ull ^ (static_cast<std::uint64_t>(key.goal) << 32 | key.rows << 16 | key.cols)) + key.profile);
+        }
+    };
+
+    // most recently used first
+    struct Entry {
+        Key key;
+        std::shared_ptr<const FlowField> field;  // nullptr while pending
+    };
+
+    // state shared with background computations, kept in a shared_ptr so a computation can finish safely even if the
+    // cache was destroyed in the meantime
+    struct State {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        size_t budget = 0;
+        size_t bytes = 0;
+        Stats stats;
+    };
+
+    // drops least recently used ready fields until the budget holds (the most recent one always stays). needs the lock
+    static void evict(State& state);
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // FLOWFIELDCACHE_H
@@ -0,0 +1,129 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+// Prevents header file from being #included multiple times
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+// Minimal C++20 coroutine generator (std::generator only arrives in C++23).
+// A function returning Generator<T> can "co_yield value;" and the caller pulls values one at a time.
+// Nothing runs until the caller asks for the first value, and the coroutine pauses after every co_yield,
+// so the caller decides how much work happens and when (e.g. a few events per animation frame).
+template <typename T>
+class Generator {
+public:
+    // the promise_type is what the compiler uses to talk to the coroutine.
+    // it stores the last yielded value so the caller can read it after resuming.
+    struct promise_type {
+        // pointer to the value passed to co_yield (lives in the coroutine frame until the next resume)
+        const T* current = nullptr;
+
+        // rethrown to the caller so errors inside the coroutine are not silently swallowed
+        std::exception_ptr exception;
+
+        Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+        // (suspend_always) lazy start, the body only runs once the caller asks for the first value
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        // stay suspended at the end so the Generator can still check done() before destroying the frame
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        // called for every "co_yield value;", remember the value and pause
+        std::suspend_always yield_value(const T& value) noexcept {
+            current = &value;
+            return {};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    // input iterator so a Generator can be used in a range based for loop: for (const auto& e : gen) {...}
+    class iterator {
+    public:
+        explicit iterator(std::coroutine_handle<promise_type> handle = nullptr) : m_handle(handle) {}
+
+        const T& operator*() const { return *m_handle.promise().current; }
+        const T* operator->() const { return m_handle.promise().current; }
+
+        // advancing the iterator resumes the coroutine until its next co_yield (or its end)
+        iterator& operator++() {
+            m_handle.resume();
+            if (m_handle.done()) {
+                rethrowIfFailed(m_handle);
+                m_handle = nullptr;
+            }
+            return *this;
+        }
+
+        // iterators are only equal when both are finished (the end() iterator holds a null handle)
+        bool operator==(const iterator& other) const noexcept { return m_handle == other.m_handle; }
+        bool operator!=(const iterator& other) const noexcept { return !(*this == other); }
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    // an empty generator that yields nothing
+    Generator() noexcept = default;
+
+    // generators own their coroutine frame, so they can be moved but not copied
+    Generator(Generator&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    ~Generator() { destroy(); }
+
+    // starts (or continues) the coroutine until the first value is available
+    iterator begin() {
+        if (!m_handle) return end();
+        return ++iterator(m_handle);
+    }
+    iterator end() noexcept { return iterator(); }
+
+    // pull style access for callers that want a fixed number of values (e.g. per timer tick).
+    // resumes the coroutine and returns false once it has finished.
+    bool next() {
+        if (!m_handle || m_handle.done()) return false;
+        m_handle.resume();
+        if (m_handle.done()) {
+            rethrowIfFailed(m_handle);
+            return false;
+        }
+        return true;
+    }
+
+    // the value produced by the last successful next()
+    const T& value() const { return *m_handle.promise().current; }
+
+    // true if there is no coroutine or it has run to the end
+    bool done() const noexcept { return !m_handle || m_handle.done(); }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+
+    static void rethrowIfFailed(std::coroutine_handle<promise_type> handle) {
+        if (handle.promise().exception) std::rethrow_exception(handle.promise().exception);
+    }
+
+    void destroy() noexcept {
+        if (m_handle) m_handle.destroy();
+        m_handle = nullptr;
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+#endif // GENERATOR_H
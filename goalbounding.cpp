@@ -0,0 +1,106 @@
+#include "goalbounding.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace {
+// file header, "GBB" + format number
+constexpr uint32_t kFileMagic = 0x31424247;
+}
+
+void GoalBounding::build(const GridModel& model, const CostProfile& profile)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    m_graph = GridGraph(model, profile);
+    const int n = m_graph.size();
+    m_boxes.assign(static_cast<size_t>(n) * 4, Box());
+
+    // every cell only writes its own 4 boxes, so the cells can be processed in parallel without locks
+    WorkerPool::instance().parallelFor(n, [&](int begin, int end) {
+        std::vector<double> dist;
+        std::vector<uint8_t> firstMove;
+        for (int source = begin; source < end; ++source) {
+            if (!m_graph.passable(source)) continue;
+
+            // cheapest paths from this cell to everywhere, then grow the box of each target's first move
+            m_graph.firstMoves(source, dist, firstMove);
+            Box* boxes = &m_boxes[static_cast<size_t>(source) * 4];
+            for (int target = 0; target < n; ++target) {
+                const uint8_t move = firstMove[target];
+                if (move == GridGraph::kNoMove) continue;
+                const auto [row, col] = m_graph.cell(target);
+                Box& box = boxes[move];
+                box.minRow = std::min(box.minRow, row);
+                box.maxRow = std::max(box.maxRow, row);
+                box.minCol = std::min(box.minCol, col);
+                box.maxCol = std::max(box.maxCol, col);
+            }
+        }
+    });
+
+    m_stats.nodes = n;
+    m_stats.bytes = m_boxes.size() * sizeof(Box);
+    m_stats.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    m_stats.loadedFromCache = false;
+}
+
+bool GoalBounding::buildCached(const GridModel& model, const std::string& cacheFile, const CostProfile& profile)
+{
+    if (load(cacheFile, model, profile)) return true;
+    build(model, profile);
+    return save(cacheFile);
+}
+
+bool GoalBounding::save(const std::string& fileName) const
+{
+    if (m_boxes.empty()) return false;
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) return false;
+
+    // header: magic number, map size and a hash of the map so load() can refuse boxes of other maps
+    const int32_t rows = m_graph.rowCount();
+    const int32_t cols = m_graph.colCount();
+    const uint64_t fingerprint = m_graph.fingerprint();
+    out.write(reinterpret_cast<const char*>(&kFileMagic), sizeof(kFileMagic));
+    out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    out.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+    out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+    out.write(reinterpret_cast<const char*>(m_boxes.data()), static_cast<std::streamsize>(m_boxes.size() * sizeof(Box)));
+    return static_cast<bool>(out);
+}
+
+bool GoalBounding::load(const std::string& fileName, const GridModel& model, const CostProfile& profile)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) return false;
+
+    // the fingerprint covers the costs, so boxes saved for another profile are refused too
+    GridGraph graph(model, profile);
+    uint32_t magic = 0;
+    int32_t rows = 0;
+    int32_t cols = 0;
+    uint64_t fingerprint = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+    in.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+    in.read(reinterpret_cast<char*>(&fingerprint), sizeof(fingerprint));
+    if (!in || magic != kFileMagic || rows != graph.rowCount() || cols != graph.colCount() || fingerprint != graph.fingerprint()) return false;
+
+    std::vector<Box> boxes(static_cast<size_t>(graph.size()) * 4);
+    if (!in.read(reinterpret_cast<char*>(boxes.data()), static_cast<std::streamsize>(boxes.size() * sizeof(Box)))) return false;
+
+    m_graph = std::move(graph);
+    m_boxes = std::move(boxes);
+    m_stats.nodes = m_graph.size();
+    m_stats.bytes = m_boxes.size() * sizeof(Box);
+    m_stats.buildMilliseconds = 0;
+    m_stats.loadedFromCache = true;
+    return true;
+}
+
+bool GoalBounding::isUpToDate(const GridModel& model) const noexcept
+{
+    return !m_boxes.empty() && m_graph.version() == model.version()
+           && m_graph.rowCount() == model.rowCount() && m_graph.colCount() == model.colCount();
+}
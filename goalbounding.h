@@ -0,0 +1,74 @@
+#ifndef GOALBOUNDING_H
+#define GOALBOUNDING_H
+
+#include "gridgraph.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Goal bounding.
+// For every cell and each of its 4 moves, stores the bounding box of all goals whose cheapest path starts with that
+// move. During A* a move can be skipped whenever the goal lies outside the move's box, because then no cheapest path
+// to the goal starts that way. The search stays optimal but only explores a thin band around the real path.
+// Preprocessing is one Dijkstra per cell (run in parallel on the WorkerPool), so the boxes are cached on disk and
+// reused for as long as the map stays the same. Hook it into a search with Pathfinder::setGoalBounding().
+class GoalBounding {
+public:
+    // inclusive box of grid cells. an empty box (no goal starts with this move) has minRow > maxRow
+    struct Box {
+        uint8_t minRow = 255;
+        uint8_t maxRow = 0;
+        uint8_t minCol = 255;
+        uint8_t maxCol = 0;
+
+        bool contains(uint8_t row, uint8_t col) const noexcept {
+            return row >= minRow && row <= maxRow && col >= minCol && col <= maxCol;
+        }
+    };
+
+    struct Stats {
+        int nodes = 0;                 // number of cells
+        size_t bytes = 0;              // memory used by the boxes
+        double buildMilliseconds = 0;  // 0 when loaded from the cache
+        bool loadedFromCache = false;
+    };
+
+    GoalBounding() = default;
+
+    // computes the boxes for the current grid and the costs of this profile (parallel over cells)
+    void build(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // loads the boxes from cacheFile if it was written for exactly this map, otherwise builds them and writes the cache.
+    // returns false only if the cache file couldnt be written (the boxes are usable either way)
+    // (use one cache file per profile, a file written for other costs is simply rebuilt)
+    bool buildCached(const GridModel& model, const std::string& cacheFile, const CostProfile& profile = CostProfile::standard());
+
+    // writes the boxes to a binary file, false if that failed or nothing was built
+    bool save(const std::string& fileName) const;
+
+    // reads boxes written by save(), false if the file is missing, damaged or belongs to a different map
+    bool load(const std::string& fileName, const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // true if the boxes were built for the model's current terrain
+    bool isUpToDate(const GridModel& model) const noexcept;
+
+    // costs the boxes were built for
+    const CostProfile& profile() const noexcept { return m_graph.profile(); }
+
+    // false if taking move (index into GridGraph::dr/dc) from (row, col) cant be the start of a cheapest path to goal
+    bool mayLeadTo(uint8_t row, uint8_t col, int move, const std::pair<uint8_t, uint8_t>& goal) const noexcept {
+        return m_boxes[(row * m_graph.colCount() + col) * 4 + move].contains(goal.first, goal.second);
+    }
+
+    const Stats& stats() const noexcept { return m_stats; }
+
+private:
+    // map the boxes belong to
+    GridGraph m_graph;
+    Stats m_stats;
+
+    // 4 boxes per cell: m_boxes[cell * 4 + move]
+    std::vector<Box> m_boxes;
+};
+
+#endif // GOALBOUNDING_H
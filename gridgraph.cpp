@@ -0,0 +1,109 @@
+#include "gridgraph.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+GridGraph::GridGraph(const GridModel& model, const CostProfile& profile)
+    : m_rows(model.rowCount()), m_cols(model.colCount()), m_version(model.version()), m_profile(profile)
+{
+    // copy every cell's cost once, so nobody has to touch the GridModel again while working on this graph
+    m_cost.resize(static_cast<size_t>(m_rows) * m_cols);
+    double minCost = std::numeric_limits<double>::infinity();
+    for (int row = 0; row < m_rows; ++row) {
+        for (int col = 0; col < m_cols; ++col) {
+            const double cost = m_profile.cost(model.cellState(row, col));
+            m_cost[row * m_cols + col] = cost;
+            if (cost >= 0) minCost = std::min(minCost, cost);
+        }
+    }
+    // an all wall grid has no passable cells, keep the default of 1.0 in that case
+    if (minCost != std::numeric_limits<double>::infinity()) m_minCost = minCost;
+}
+
+void GridGraph::refreshCell(const GridModel& model, std::uint8_t row, std::uint8_t col)
+{
+    const double cost = m_profile.cost(model.cellState(row, col));
+    m_cost[index(row, col)] = cost;
+    // the minimum can only be lowered here, a stale (too low) minimum still keeps heuristics admissible
+    if (cost >= 0) m_minCost = std::min(m_minCost, cost);
+    m_version = model.version();
+}
+
+int GridGraph::directionTo(int a, int b) const noexcept
+{
+    for (int direction = 0; direction < 4; ++direction) {
+        const int nr = a / m_cols + dr[direction];
+        const int nc = a % m_cols + dc[direction];
+        if (nr >= 0 && nr < m_rows && nc >= 0 && nc < m_cols && nr * m_cols + nc == b) return direction;
+    }
+    return -1;
+}
+
+void GridGraph::firstMoves(int source, std::vector<double>& dist, std::vector<std::uint8_t>& firstMove) const
+{
+    dist.assign(size(), std::numeric_limits<double>::infinity());
+    firstMove.assign(size(), kNoMove);
+    if (!passable(source)) return;
+
+    // plain Dijkstra (min-heap of {cost, node}), every node remembers the first move of its best path
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+    dist[source] = 0.0;
+    queue.push({0.0, source});
+    while (!queue.empty()) {
+        const auto [d, current] = queue.top();
+        queue.pop();
+        // stale entry
+        if (d > dist[current]) continue;
+        forEachNeighbour(current, [&](int nb, int direction) {
+            const double newDist = d + cost(nb);
+            if (newDist < dist[nb]) {
+                dist[nb] = newDist;
+                // neighbours of the source start a new branch, everything else inherits its parent's first move
+                firstMove[nb] = current == source ? static_cast<std::uint8_t>(direction) : firstMove[current];
+                queue.push({newDist, nb});
+            }
+        });
+    }
+}
+
+std::vector<int> GridGraph::components() const
+{
+    // flood fill from every passable cell that doesnt have an id yet
+    std::vector<int> component(size(), -1);
+    std::vector<int> stack;
+    int nextId = 0;
+    for (int start = 0; start < size(); ++start) {
+        if (!passable(start) || component[start] != -1) continue;
+        component[start] = nextId;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            const int current = stack.back();
+            stack.pop_back();
+            forEachNeighbour(current, [&](int n, int) {
+                if (component[n] == -1) {
+                    component[n] = nextId;
+                    stack.push_back(n);
+                }
+            });
+        }
+        ++nextId;
+    }
+    return component;
+}
+
+std::uint64_t GridGraph::fingerprint() const noexcept
+{
+    // FNV-1a hash over the bytes of the dimensions and the costs
+    std::uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const auto* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i) {
+            hash ^= p[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(&m_rows, sizeof(m_rows));
+    mix(&m_cols, sizeof(m_cols));
+    mix(m_cost.data(), m_cost.size() * sizeof(double));
+    return hash;
+}
@@ -0,0 +1,104 @@
+#ifndef GRIDGRAPH_H
+#define GRIDGRAPH_H
+
+#include "gridmodel.h"
+#include "costprofile.h"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// A read only snapshot of a GridModel seen as a graph: every cell is a node, and moving into a neighbouring cell
+// costs that cell's terrain cost under a CostProfile (the standard one unless given, walls are impassable).
+// Cells are numbered row by row (index = row * cols + col) so whole grids fit in flat vectors.
+// Because it is a copy, preprocessing can run on worker threads while the user keeps editing the GridModel.
+class GridGraph {
+public:
+    // Movement directions, same order as the A* loop in Pathfinder (up, down, left, right).
+    static constexpr std::array<int, 4> dr = {-1, 1, 0, 0};
+    static constexpr std::array<int, 4> dc = {0, 0, -1, 1};
+
+    // empty graph (0x0), useful as a placeholder before anything is built
+    GridGraph() = default;
+
+    // copies the terrain costs of every cell of the model, as seen by agents of this profile
+    explicit GridGraph(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    int rowCount() const noexcept { return m_rows; }
+    int colCount() const noexcept { return m_cols; }
+
+    // number of nodes (cells) in the graph
+    int size() const noexcept { return m_rows * m_cols; }
+
+    // version of the GridModel this snapshot was taken from (see GridModel::version())
+    std::uint64_t version() const noexcept { return m_version; }
+
+    // profile the costs were taken from
+    const CostProfile& profile() const noexcept { return m_profile; }
+
+    // conversions between (row, col) and flat node indices
+    int index(std::uint8_t row, std::uint8_t col) const noexcept { return row * m_cols + col; }
+    int index(const std::pair<std::uint8_t, std::uint8_t>& cell) const noexcept { return index(cell.first, cell.second); }
+    std::pair<std::uint8_t, std::uint8_t> cell(int index) const noexcept {
+        return {static_cast<std::uint8_t>(index / m_cols), static_cast<std::uint8_t>(index % m_cols)};
+    }
+
+    // cost of moving into this node, -1 for walls
+    double cost(int index) const noexcept { return m_cost[index]; }
+    bool passable(int index) const noexcept { return m_cost[index] >= 0; }
+
+    // neighbour of a node in direction (0-3), or -1 if it is outside the grid or a wall
+    int neighbour(int index, int direction) const noexcept {
+        const int nr = index / m_cols + dr[direction];
+        const int nc = index % m_cols + dc[direction];
+        if (nr < 0 || nr >= m_rows || nc < 0 || nc >= m_cols) return -1;
+        const int n = nr * m_cols + nc;
+        return passable(n) ? n : -1;
+    }
+
+    // calls visit(neighbourIndex, direction) for every passable neighbour
+    template <typename Visit>
+    void forEachNeighbour(int index, Visit&& visit) const {
+        for (int direction = 0; direction < 4; ++direction) {
+            const int n = neighbour(index, direction);
+            if (n >= 0) visit(n, direction);
+        }
+    }
+
+    // direction that leads from node a to the neighbouring node b (or -1 if they are not neighbours)
+    int directionTo(int a, int b) const noexcept;
+
+    // value used in firstMoves() for nodes that have no first move (the source itself, walls, unreachable nodes)
+    static constexpr std::uint8_t kNoMove = 255;
+
+    // Dijkstra from source over the whole graph. fills dist with the cheapest cost to every node (infinity if
+    // unreachable) and firstMove with the direction of the first step of that cheapest path (kNoMove if there is none).
+    // the vectors are resized as needed, so callers running many searches can reuse them to avoid allocations.
+    void firstMoves(int source, std::vector<double>& dist, std::vector<std::uint8_t>& firstMove) const;
+
+    // connected component id of every node (-1 for walls). two cells are reachable from each other only if the ids match.
+    std::vector<int> components() const;
+
+    // copies the current state of one cell from the model (for engines that repair themselves after edits instead of
+    // rebuilding) and takes over the model's version
+    void refreshCell(const GridModel& model, std::uint8_t row, std::uint8_t col);
+
+    // cheapest cost of entering any passable cell (used to keep heuristics admissible)
+    double minCost() const noexcept { return m_minCost; }
+
+    // 64 bit hash of the dimensions and every terrain cost, used to check that data saved to disk belongs to this map
+    std::uint64_t fingerprint() const noexcept;
+
+private:
+    int m_rows = 0;
+    int m_cols = 0;
+    std::uint64_t m_version = 0;
+    double m_minCost = 1.0;
+    CostProfile m_profile;
+
+    // terrain cost of every cell, indexed by node index
+    std::vector<double> m_cost;
+};
+
+#endif // GRIDGRAPH_H
@@ -13,6 +13,9 @@ GridModel::GridModel(std::uint8_t rows, std::uint8_t cols, QObject* parent)
     for (auto& row : m_grid) {
         row.resize(m_cols, CellType::Normal);
     }
+
+    // no walls yet, so every cell's clearance only depends on its distance to the bottom/right edge
+    rebuildClearance();
 }
 
 // Returns the state of a specific cell
@@ -38,7 +41,9 @@ void GridModel::setCellState(std::uint8_t row, std::uint8_t col, CellType type)
         }
     } else {
         // For normal cell types
-        m_grid[row][col] = type;
+        // a terrain change makes preprocessed data built from the old grid out of date
+        if (changesTerrain(m_grid[row][col], type)) ++m_version;
+        writeCell(row, col, type);
         // emit cellUpdated signal
         emit cellUpdated(row, col);
     }
@@ -53,14 +58,101 @@ void GridModel::clearGrid() {
     // reset start and goal position to default
     m_start = {101, 101};
     m_goal = {101, 101};
+    // whole grid changed
+    ++m_version;
+    rebuildClearance();
     // emit gridReset signal
     emit gridReset();
 }
 
+// Returns the clearance of a specific cell
+std::uint8_t GridModel::clearance(std::uint8_t row, std::uint8_t col) const {
+    // ensure valid co-ordinates
+    validateCoordinates(row, col);
+
+    return m_clearance[row][col];
+}
+
+// Writes a cell and keeps the clearance map in sync
+void GridModel::writeCell(std::uint8_t row, std::uint8_t col, CellType type) {
+    const bool wasWall = m_grid[row][col] == CellType::Wall;
+    m_grid[row][col] = type;
+    // only walls matter for clearance
+    if (wasWall != (type == CellType::Wall)) updateClearance(row, col);
+}
+
+// Recomputes the clearance of every cell
+void GridModel::rebuildClearance() {
+    m_clearance.assign(m_rows, std::vector<std::uint8_t>(m_cols, 0));
+
+    // bottom right to top left, so the 3 cells a value depends on are always done already
+    for (int row = m_rows - 1; row >= 0; --row) {
+        for (int col = m_cols - 1; col >= 0; --col) {
+            if (m_grid[row][col] == CellType::Wall) continue;
+            const int below = row + 1 < m_rows ? m_clearance[row + 1][col] : 0;
+            const int right = col + 1 < m_cols ? m_clearance[row][col + 1] : 0;
+            const int diagonal = row + 1 < m_rows && col + 1 < m_cols ? m_clearance[row + 1][col + 1] : 0;
+            m_clearance[row][col] = static_cast<std::uint8_t>(1 + std::min({below, right, diagonal}));
+        }
+    }
+}
+
+// Repairs the clearance after (row, col) changed between wall and non wall
+void GridModel::updateClearance(std::uint8_t row, std::uint8_t col) {
+    // a cell's clearance is 1 + the smallest of the cells below, to the right and diagonally below right (0 for walls),
+    // so a change only travels up and to the left
+    auto recompute = [this](int r, int c) {
+        std::uint8_t value = 0;
+        if (m_grid[r][c] != CellType::Wall) {
+            const int below = r + 1 < m_rows ? m_clearance[r + 1][c] : 0;
+            const int right = c + 1 < m_cols ? m_clearance[r][c + 1] : 0;
+            const int diagonal = r + 1 < m_rows && c + 1 < m_cols ? m_clearance[r + 1][c + 1] : 0;
+            value = static_cast<std::uint8_t>(1 + std::min({below, right, diagonal}));
+        }
+        const bool changed = value != m_clearance[r][c];
+        m_clearance[r][c] = value;
+        return changed;
+    };
+
+    // columns of the row below that changed ([low, high], empty if low > high). the edited cell itself starts it off
+    int low = col;
+    int high = col;
+    bool force = true;
+    for (int r = row; r >= 0 && low <= high; --r) {
+        int rowLow = m_cols;
+        int rowHigh = -1;
+        bool rightChanged = false;
+        // a cell depends on the row below at its own column and the one to its right, and on its right neighbour.
+        // walk right to left from the rightmost cell that can be affected, until nothing can change anymore
+        for (int c = high; c >= 0; --c) {
+            const bool fromBelow = force ? c == col : (c >= low - 1 && c <= high);
+            if (!fromBelow && !rightChanged) {
+                if (c < low - 1) break;
+                continue;
+            }
+            rightChanged = recompute(r, c) || (force && c == col);
+            if (rightChanged) {
+                rowLow = std::min(rowLow, c);
+                rowHigh = std::max(rowHigh, c);
+            }
+        }
+        force = false;
+        low = rowLow;
+        high = rowHigh;
+    }
+}
+
 // Returns the current start/goal positions as a (std::pair)
 std::pair<std::uint8_t, std::uint8_t> GridModel::startPosition() const { return m_start; }
 std::pair<std::uint8_t, std::uint8_t> GridModel::goalPosition() const { return m_goal; }
 
+// Start and Goal cells are ordinary ground as far as movement is concerned, so swapping between Normal/Start/Goal
+// doesnt change the terrain (moving the start or goal around must not throw away preprocessed data)
+bool GridModel::changesTerrain(CellType oldType, CellType newType) noexcept {
+    auto isGround = [](CellType type) { return type == CellType::Normal || type == CellType::Start || type == CellType::Goal; };
+    return oldType != newType && !(isGround(oldType) && isGround(newType));
+}
+
 // Validates if coordinates are within grid bounds
 void GridModel::validateCoordinates(std::uint8_t row, std::uint8_t col) const {
     if (row >= m_rows || col >= m_cols) {
@@ -77,13 +169,16 @@ void GridModel::updateSpecialPosition(std::pair<std::uint8_t, std::uint8_t>& pos
 
     // Clear previous position if valid
     if (oldRow != 101 || oldCol != 101) {
-        m_grid[oldRow][oldCol] = CellType::Normal;
+        // (the old cell may have been painted over with terrain since, which then disappears)
+        if (changesTerrain(m_grid[oldRow][oldCol], CellType::Normal)) ++m_version;
+        writeCell(oldRow, oldCol, CellType::Normal);
         emit cellUpdated(oldRow, oldCol);
     }
 
     // Update to new position
     position = {newRow, newCol};
-    m_grid[newRow][newCol] = positionType;
+    if (changesTerrain(m_grid[newRow][newCol], positionType)) ++m_version;
+    writeCell(newRow, newCol, positionType);
     emit cellUpdated(newRow, newCol);
 
     // Emit position change signal
@@ -50,6 +50,16 @@ public:
     std::pair<std::uint8_t, std::uint8_t> startPosition() const;
     std::pair<std::uint8_t, std::uint8_t> goalPosition() const;
 
+    // counter that goes up every time the terrain changes (a cell becomes a wall/rough/boost or stops being one, or the grid is cleared).
+    // moving the start or goal doesnt count since those cells cost the same as normal ones.
+    // preprocessed data (path databases, caches) remembers the version it was built from to know when it is out of date.
+    std::uint64_t version() const noexcept { return m_version; }
+
+    // true clearance of a cell: the side length of the largest square without walls that has this cell as its top left
+    // corner (0 for walls). an agent that covers size x size cells (anchored at its top left cell) fits on a cell if
+    // clearance >= size, so one map answers this for every agent size. kept up to date on every edit.
+    std::uint8_t clearance(std::uint8_t row, std::uint8_t col) const;
+
 private:
     // Core data members
     const std::uint8_t m_rows;
@@ -60,10 +70,29 @@ private:
     std::pair<std::uint8_t, std::uint8_t> m_start {101, 101};
     std::pair<std::uint8_t, std::uint8_t> m_goal {101, 101};
 
+    // see version()
+    std::uint64_t m_version = 0;
+
+    // see clearance(), same layout as m_grid
+    std::vector<std::vector<std::uint8_t>> m_clearance;
+
     // Validation utilities
     // check if the given cell position is within the grid
     void validateCoordinates(std::uint8_t row, std::uint8_t col) const;
 
+    // true if replacing oldType by newType changes the movement cost of the cell (see version())
+    static bool changesTerrain(CellType oldType, CellType newType) noexcept;
+
+    // recomputes the clearance of cells whose square can include (row, col) after it became a wall or stopped being one.
+    // only the cells up and to the left can be affected, and the update stops as soon as the values stop changing.
+    void updateClearance(std::uint8_t row, std::uint8_t col);
+
+    // recomputes the whole clearance map
+    void rebuildClearance();
+
+    // writes a new type into the grid and updates the clearance map if the cell became a wall or stopped being one
+    void writeCell(std::uint8_t row, std::uint8_t col, CellType type);
+
     // updates the position for either the goal/start state
     void updateSpecialPosition(std::pair<std::uint8_t, std::uint8_t>& position, std::uint8_t newRow, std::uint8_t newCol, CellType positionType);
 
@@ -2,6 +2,7 @@
 #include <QPainter>
 #include <QMouseEvent>
 #include <QPainterPath>
+#include <algorithm>
 
 GridView::GridView(GridModel* model, QWidget* parent)
     : QWidget(parent), // Initialize base QWidget
@@ -50,6 +51,9 @@ void GridView::paintEvent(QPaintEvent* event) {
         {GridModel::Goal,    Qt::red}
     };
 
+    // walls may have moved since the overlay was last shown
+    if (m_showDistances && !m_distanceTransform.isUpToDate(*m_model)) m_distanceTransform.compute(*m_model);
+
     // paint the grid cells
     for (int row = 0; row < rows; ++row) {
         for (int col = 0; col < cols; ++col) {
@@ -68,6 +72,17 @@ void GridView::paintEvent(QPaintEvent* event) {
             // (2) if celltype was not found then paints it default Qt::white
             painter.fillRect(cell_rect, (it != color_map.end()) ? it->second : Qt::white);
 
+            // distance overlay: red right next to walls, fading to nothing 8 cells away (walls themselves stay gray)
+            if (m_showDistances && type != GridModel::Wall) {
+                const double distance = m_distanceTransform.distance(row, col);
+                if (distance < 8.0) painter.fillRect(cell_rect, QColor(220, 40, 40, static_cast<int>(160 * (1.0 - distance / 8.0))));
+            }
+
+            // tint cells touched by the visualized search (light blue = discovered, stronger blue = expanded)
+            if (!m_searchState.empty() && m_searchState[row][col] != 0) {
+                painter.fillRect(cell_rect, m_searchState[row][col] == 2 ? QColor(70, 130, 220, 120) : QColor(120, 200, 255, 90));
+            }
+
             // set the pen color for drawing the cell border
             painter.setPen(Qt::gray);
 
@@ -152,6 +167,11 @@ void GridView::makeConnections()
     // receiver object: this (aka GridView object).
     // receiver slot: lamda function [this](uint8_t row, uint8_t col)
     connect(m_model, &GridModel::cellUpdated, this, [this](uint8_t row, uint8_t col) {
+        // a wall change moves the distance overlay of many cells, so repaint everything while it is shown
+        if (m_showDistances) {
+            update();
+            return;
+        }
         update(QRect(col * m_cellSize, row * m_cellSize, m_cellSize, m_cellSize));
     });
 
@@ -161,6 +181,7 @@ void GridView::makeConnections()
     // receiver object: this (aka GridView object).
     // receiver slot: lamda function [this]
     connect(m_model, &GridModel::gridReset, this, [this]() {
+        clearSearch();
         m_currentPath.clear();
         m_animatingPath.clear();
         update();
@@ -171,6 +192,9 @@ void GridView::makeConnections()
     // refers to the current GridView instance.
     // advance animation is the slot thats called
     connect(&m_animationTimer, &QTimer::timeout, this, &GridView::advanceAnimation);
+
+    // every tick of m_searchTimer shows the next batch of search events
+    connect(&m_searchTimer, &QTimer::timeout, this, &GridView::advanceSearch);
 }
 
 void GridView::setPath(const std::vector<std::pair<uint8_t, uint8_t> > &path)
@@ -194,3 +218,64 @@ void GridView::advanceAnimation() {
         m_animationTimer.stop();
     }
 }
+
+void GridView::visualizeSearch()
+{
+    // stop any previous visualization and hide the old path
+    clearSearch();
+    m_currentPath.clear();
+    m_animatingPath.clear();
+
+    // one entry per cell, all untouched
+    m_searchState.assign(m_model->rowCount(), std::vector<uint8_t>(m_model->colCount(), 0));
+
+    // the generator keeps a reference to the pathfinder, so the pathfinder is owned here for as long as the search runs
+    m_searchPathfinder = std::make_unique<Pathfinder>(*m_model);
+    m_searchEvents = m_searchPathfinder->searchEvents();
+
+    // Update every 15ms
+    m_searchTimer.start(15);
+    update();
+}
+
+void GridView::setDistanceOverlay(bool enabled)
+{
+    m_showDistances = enabled;
+    update();
+}
+
+void GridView::clearSearch()
+{
+    m_searchTimer.stop();
+    // destroy the coroutine before the pathfinder it refers to
+    m_searchEvents = {};
+    m_searchPathfinder.reset();
+    m_searchState.clear();
+    update();
+}
+
+void GridView::advanceSearch()
+{
+    // pull at most m_eventsPerTick events, the rest of the search stays suspended until the next tick
+    for (int i = 0; i < m_eventsPerTick && m_searchEvents.next(); ++i) {
+        const auto& event = m_searchEvents.value();
+
+        // the search has ended, show the path it found and report the cost
+        if (event.type == Pathfinder::SearchEvent::Finished) {
+            m_searchTimer.stop();
+            const auto result = m_searchPathfinder->lastResult();
+            setPath(result.path);
+            emit searchFinished(result.totalCost);
+            return;
+        }
+
+        // never downgrade an expanded cell back to discovered
+        auto& state = m_searchState[event.row][event.col];
+        state = std::max<uint8_t>(state, event.type == Pathfinder::SearchEvent::Expanded ? 2 : 1);
+    }
+
+    // generator ran out without a Finished event (shouldnt happen) so just stop
+    if (m_searchEvents.done()) m_searchTimer.stop();
+
+    update();
+}
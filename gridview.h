@@ -3,7 +3,10 @@
 
 #include <QWidget>
 #include <QTimer>
+#include <memory>
 #include "gridmodel.h"
+#include "pathfinder.h"
+#include "distancetransform.h"
 
 class GridView : public QWidget
 {
@@ -21,6 +24,13 @@ public slots:
     // set the current path to this path
     void setPath(const std::vector<std::pair<uint8_t, uint8_t>>& path);
 
+    // runs A* on the current grid and animates it, pulling m_eventsPerTick search events from the coroutine every tick.
+    // once the search finishes the found path is animated with setPath() and searchFinished() is emitted.
+    void visualizeSearch();
+
+    // shows/hides the distance to the nearest wall as a tint over every cell (recomputed lazily after terrain edits)
+    void setDistanceOverlay(bool enabled);
+
 // protected as these are protected virtual methods in QWidget class, if private then wouldnt allow overriding.
 // recall a virtual method is made to be overriden by derived classes
 protected:
@@ -63,10 +73,31 @@ private:
     // used for an index to iterate through the path and animate elements
     size_t m_currentAnimationStep = 0;
 
+    // pathfinder used for the search visualization, kept alive as long as its event generator is running
+    std::unique_ptr<Pathfinder> m_searchPathfinder;
+    // lazily produces the search events, nothing is computed until advanceSearch() pulls them
+    Generator<Pathfinder::SearchEvent> m_searchEvents;
+    // QTimer for the animation of the search
+    QTimer m_searchTimer;
+    // how many search events are shown per timer tick
+    int m_eventsPerTick = 40;
+    // per cell state of the visualized search: 0 = untouched, 1 = discovered (in queue), 2 = expanded
+    std::vector<std::vector<uint8_t>> m_searchState;
+
+    // distances to the nearest wall for the overlay, only computed while the overlay is shown
+    DistanceTransform m_distanceTransform;
+    bool m_showDistances = false;
+
+    // stops a running search visualization and removes the explored cells overlay
+    void clearSearch();
+
 private slots:
     // go to the next index for path animation if there is still steps to animate
     void advanceAnimation();
 
+    // pull the next batch of events from the search coroutine and repaint
+    void advanceSearch();
+
 signals:
     // emits a signal when cell is clicked
     void cellClicked(uint8_t row, uint8_t col);
@@ -77,6 +108,9 @@ signals:
     // (2) Algorithm packages path as vector of coordinates.
     // (3) Signal emitted with result emit pathFound(calculatedPath).
     void pathFound(const std::vector<std::pair<uint8_t, uint8_t>>& path);
+
+    // emitted when a visualized search ends, cost is -1 if there is no path
+    void searchFinished(double totalCost);
 };
 
 #endif // GRIDVIEW_H
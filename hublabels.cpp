@@ -0,0 +1,299 @@
+#include "hublabels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// file header, "HUB" + format number (2: double distances)
+constexpr uint32_t kFileMagic = 0x32425548;
+
+// profiles allow any costs, so sums of the same path added up in a different order can differ in the last bits.
+// distances this close count as equal
+bool sameDistance(double a, double b)
+{
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(b));
+}
+
+// hub order: the cells that split the map into halves come first, then the cells splitting those halves, etc.
+// shortest paths between the halves have to cross the splitting line, so those cells are the best hubs and
+// everything after them gets pruned early, which keeps the labels short.
+std::vector<int> separatorOrder(const GridGraph& graph)
+{
+    struct Area { int top, left, bottom, right; }; // inclusive bounds
+    std::vector<int> order;
+    std::queue<Area> areas;
+    areas.push({0, 0, graph.rowCount() - 1, graph.colCount() - 1});
+
+    // breadth first so all separators of one level come before any of the next level
+    while (!areas.empty()) {
+        const Area area = areas.front();
+        areas.pop();
+        if (area.top > area.bottom || area.left > area.right) continue;
+
+        const int height = area.bottom - area.top + 1;
+        const int width = area.right - area.left + 1;
+        if (height >= width) {
+            // cut along the middle row
+            const int mid = area.top + height / 2;
+            for (int col = area.left; col <= area.right; ++col) order.push_back(mid * graph.colCount() + col);
+            areas.push({area.top, area.left, mid - 1, area.right});
+            areas.push({mid + 1, area.left, area.bottom, area.right});
+        } else {
+            // cut along the middle column
+            const int mid = area.left + width / 2;
+            for (int row = area.top; row <= area.bottom; ++row) order.push_back(row * graph.colCount() + mid);
+            areas.push({area.top, area.left, area.bottom, mid - 1});
+            areas.push({area.top, mid + 1, area.bottom, area.right});
+        }
+    }
+
+    // walls are never hubs
+    order.erase(std::remove_if(order.begin(), order.end(), [&graph](int v) { return !graph.passable(v); }), order.end());
+    return order;
+}
+}
+
+HubLabels::HubLabels(const GridModel& model, const CostProfile& profile)
+{
+    build(model, profile);
+}
+
+void HubLabels::build(const GridModel& model, const CostProfile& profile)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    m_graph = GridGraph(model, profile);
+    const int n = m_graph.size();
+    const std::vector<int> order = separatorOrder(m_graph);
+
+    // labels while building (entries get appended in hub order, so every list is sorted by hub automatically)
+    std::vector<std::vector<Entry>> outLabels(n), inLabels(n);
+
+    std::vector<double> dist(n, kInfinity);
+    std::vector<int> touched;
+    // hubLabel[x] = distance between the current hub and hub x taken from the hub's own label (for pruning)
+    std::vector<double> hubLabel(order.size(), kInfinity);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+
+    // one pruned Dijkstra from the hub. forward = distances hub -> v go into in(v), otherwise v -> hub go into out(v).
+    // a cell is pruned (not labelled and not expanded) if the labels built so far already give its distance, since
+    // then some earlier, more important hub covers every path through it.
+    auto prunedSearch = [&](uint32_t hubRank, bool forward) {
+        const int hub = order[hubRank];
+        auto& hubOwn = forward ? outLabels[hub] : inLabels[hub];
+        auto& targetLabels = forward ? inLabels : outLabels;
+        for (const Entry& entry : hubOwn) hubLabel[entry.hub] = entry.distance;
+
+        dist[hub] = 0.0;
+        touched.push_back(hub);
+        queue.push({0.0, hub});
+        while (!queue.empty()) {
+            const auto [d, v] = queue.top();
+            queue.pop();
+            if (d > dist[v]) continue;
+
+            // distance the existing labels already give for hub -> v (or v -> hub)
+            double known = kInfinity;
+            for (const Entry& entry : targetLabels[v]) known = std::min(known, hubLabel[entry.hub] + entry.distance);
+            if (known <= d || sameDistance(known, d)) continue;
+
+            targetLabels[v].push_back({hubRank, d});
+
+            // forward: moving v -> nb costs cost(nb). backward: we walk edges in reverse, nb -> v costs cost(v)
+            m_graph.forEachNeighbour(v, [&](int nb, int) {
+                const double newDist = d + (forward ? m_graph.cost(nb) : m_graph.cost(v));
+                if (newDist < dist[nb]) {
+                    if (dist[nb] == kInfinity) touched.push_back(nb);
+                    dist[nb] = newDist;
+                    queue.push({newDist, nb});
+                }
+            });
+        }
+
+        for (int v : touched) dist[v] = kInfinity;
+        touched.clear();
+        for (const Entry& entry : hubOwn) hubLabel[entry.hub] = kInfinity;
+    };
+
+    for (uint32_t hubRank = 0; hubRank < order.size(); ++hubRank) {
+        prunedSearch(hubRank, true);
+        prunedSearch(hubRank, false);
+    }
+
+    // lay the labels out as one block: header, out offsets, in offsets, out entries, in entries
+    size_t outCount = 0, inCount = 0;
+    for (int v = 0; v < n; ++v) {
+        outCount += outLabels[v].size();
+        inCount += inLabels[v].size();
+    }
+    const size_t offsetsBytes = (static_cast<size_t>(n) + 1) * sizeof(uint32_t);
+    std::vector<unsigned char> buffer(sizeof(Header) + 2 * offsetsBytes + (outCount + inCount) * sizeof(Entry));
+
+    Header header {kFileMagic, m_graph.rowCount(), m_graph.colCount(), static_cast<uint32_t>(outCount), m_graph.fingerprint()};
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+    auto* outOffsets = reinterpret_cast<uint32_t*>(buffer.data() + sizeof(Header));
+    auto* inOffsets = reinterpret_cast<uint32_t*>(buffer.data() + sizeof(Header) + offsetsBytes);
+    auto* outEntries = reinterpret_cast<Entry*>(buffer.data() + sizeof(Header) + 2 * offsetsBytes);
+    auto* inEntries = outEntries + outCount;
+    outOffsets[0] = inOffsets[0] = 0;
+    for (int v = 0; v < n; ++v) {
+        std::copy(outLabels[v].begin(), outLabels[v].end(), outEntries + outOffsets[v]);
+        std::copy(inLabels[v].begin(), inLabels[v].end(), inEntries + inOffsets[v]);
+        outOffsets[v + 1] = outOffsets[v] + static_cast<uint32_t>(outLabels[v].size());
+        inOffsets[v + 1] = inOffsets[v] + static_cast<uint32_t>(inLabels[v].size());
+    }
+
+    m_file.reset();
+    m_buffer = std::move(buffer);
+    attach(m_buffer.data(), m_buffer.size());
+    m_stats.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    m_stats.memoryMapped = false;
+}
+
+bool HubLabels::attach(const unsigned char* data, size_t size)
+{
+    m_data = nullptr;
+    const size_t n = static_cast<size_t>(m_graph.size());
+    const size_t offsetsBytes = (n + 1) * sizeof(uint32_t);
+    if (size < sizeof(Header) + 2 * offsetsBytes) return false;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic != kFileMagic || header.rows != m_graph.rowCount() || header.cols != m_graph.colCount()
+        || header.fingerprint != m_graph.fingerprint()) return false;
+
+    const auto* outOffsets = reinterpret_cast<const uint32_t*>(data + sizeof(Header));
+    const auto* inOffsets = reinterpret_cast<const uint32_t*>(data + sizeof(Header) + offsetsBytes);
+    const size_t outCount = outOffsets[n];
+    const size_t inCount = inOffsets[n];
+    if (outCount != header.outEntries || size != sizeof(Header) + 2 * offsetsBytes + (outCount + inCount) * sizeof(Entry)) return false;
+
+    // the fingerprint only covers the map, so check the labels themselves before query() trusts them: offsets start at
+    // 0, never decrease and stay within their entry counts, and every label holds valid hub ranks
+    // (every passable cell is a hub) in increasing order
+    const auto* out = reinterpret_cast<const Entry*>(data + sizeof(Header) + 2 * offsetsBytes);
+    const auto* in = out + outCount;
+    size_t hubs = 0;
+    for (size_t v = 0; v < n; ++v) hubs += m_graph.passable(static_cast<int>(v));
+    auto validLabels = [n, hubs](const uint32_t* offsets, const Entry* entries, size_t count) {
+        if (offsets[0] != 0) return false;
+        for (size_t v = 0; v < n; ++v) {
+            if (offsets[v + 1] < offsets[v] || offsets[v + 1] > count) return false;
+            for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) {
+                if (entries[i].hub >= hubs || (i > offsets[v] && entries[i].hub <= entries[i - 1].hub)) return false;
+            }
+        }
+        return true;
+    };
+    if (!validLabels(outOffsets, out, outCount) || !validLabels(inOffsets, in, inCount)) return false;
+
+    m_data = data;
+    m_outOffsets = outOffsets;
+    m_inOffsets = inOffsets;
+    m_out = out;
+    m_in = in;
+
+    m_stats = {};
+    m_stats.nodes = static_cast<int>(hubs);
+    m_stats.labelEntries = outCount + inCount;
+    m_stats.averageLabelSize = m_stats.nodes ? static_cast<double>(m_stats.labelEntries) / (2.0 * m_stats.nodes) : 0.0;
+    m_stats.bytes = size;
+    return true;
+}
+
+bool HubLabels::save(const std::string& fileName) const
+{
+    if (!m_data) return false;
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(m_data), static_cast<std::streamsize>(m_stats.bytes));
+    return static_cast<bool>(out);
+}
+
+bool HubLabels::map(const std::string& fileName, const GridModel& model, const CostProfile& profile)
+{
+    // the graph is still needed for path retrieval and to check the file belongs to this map
+    m_graph = GridGraph(model, profile);
+    m_buffer.clear();
+    m_data = nullptr;
+
+    auto file = std::make_unique<QFile>(QString::fromStdString(fileName));
+    if (!file->open(QIODevice::ReadOnly)) return false;
+    const qint64 size = file->size();
+    const unsigned char* data = size > 0 ? file->map(0, size) : nullptr;
+    if (!data || !attach(data, static_cast<size_t>(size))) return false;
+
+    // the mapping lives as long as the QFile, so keep it
+    m_file = std::move(file);
+    m_stats.memoryMapped = true;
+    return true;
+}
+
+double HubLabels::query(int s, int t) const
+{
+    // both labels are sorted by hub, so walk them side by side like the merge step of merge sort
+    const Entry* a = m_out + m_outOffsets[s];
+    const Entry* aEnd = m_out + m_outOffsets[s + 1];
+    const Entry* b = m_in + m_inOffsets[t];
+    const Entry* bEnd = m_in + m_inOffsets[t + 1];
+    double best = kInfinity;
+    while (a != aEnd && b != bEnd) {
+        if (a->hub < b->hub) {
+            ++a;
+        } else if (a->hub > b->hub) {
+            ++b;
+        } else {
+            best = std::min(best, a->distance + b->distance);
+            ++a;
+            ++b;
+        }
+    }
+    return best;
+}
+
+double HubLabels::distance(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    if (!m_data || start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return -1;
+    const double d = query(m_graph.index(start), m_graph.index(goal));
+    return d == kInfinity ? -1 : d;
+}
+
+Pathfinder::PathResult HubLabels::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    Pathfinder::PathResult result;
+    result.totalCost = distance(start, goal);
+    if (result.totalCost < 0) return result;
+
+    // step to whichever neighbour lies on a shortest path: entering it costs what the remaining distance drops by.
+    // every cost is positive, so the remaining distance strictly drops and no cell is visited twice
+    const int t = m_graph.index(goal);
+    int current = m_graph.index(start);
+    double remaining = result.totalCost;
+    result.path.push_back(start);
+    while (current != t) {
+        int next = -1;
+        double nextRemaining = 0.0;
+        m_graph.forEachNeighbour(current, [&](int nb, int) {
+            if (next >= 0) return;
+            const double rest = query(nb, t);
+            if (rest < remaining && sameDistance(rest + m_graph.cost(nb), remaining)) {
+                next = nb;
+                nextRemaining = rest;
+            }
+        });
+        // labels that dont match the map (cant happen with a fingerprint check) would leave us stuck, and a real path
+        // never has more cells than the grid
+        if (next < 0 || static_cast<int>(result.path.size()) > m_graph.size()) return {{}, -1};
+        remaining = nextRemaining;
+        current = next;
+        result.path.push_back(m_graph.cell(current));
+    }
+    return result;
+}
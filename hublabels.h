@@ -0,0 +1,96 @@
+#ifndef HUBLABELS_H
+#define HUBLABELS_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <QFile>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Hub labeling distance oracle.
+// Every cell v gets two short sorted lists ("labels"): hubs it can reach with their distances (out label) and hubs
+// that can reach it with their distances (in label). The labels are built so that every shortest path s -> t passes
+// through at least one hub that is in both out(s) and in(t), so the exact cost is
+//     min over common hubs h of  out(s)[h] + in(t)[h]
+// which is just a merge of two sorted lists, no search at all. Great for callers that only need costs (e.g. ranking
+// candidate destinations). Getting the actual path is possible but slower (a distance query per step).
+// Labels are stored in one flat block with the same layout as the file written by save(), so a saved index can be
+// memory mapped with map() and used straight away without loading or parsing anything.
+class HubLabels {
+public:
+    struct Stats {
+        int nodes = 0;                 // passable cells
+        size_t labelEntries = 0;       // entries in all in + out labels together
+        double averageLabelSize = 0;   // entries per cell per direction
+        size_t bytes = 0;              // size of the label block
+        double buildMilliseconds = 0;  // 0 when memory mapped from a file
+        bool memoryMapped = false;
+    };
+
+    // empty index, use build() or map()
+    HubLabels() = default;
+
+    // builds the labels for the current grid (pruned landmark labeling) with the costs of one profile
+    explicit HubLabels(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    void build(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // writes the label block to a file. returns false if it couldnt be written or nothing was built
+    bool save(const std::string& fileName) const;
+
+    // memory maps a file written by save(). returns false if the file is missing, damaged or for a different map
+    // (or for other costs than the profile's)
+    bool map(const std::string& fileName, const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // true once labels are available
+    bool isReady() const noexcept { return m_data != nullptr; }
+
+    // exact cost of the cheapest path, -1 if there is none
+    double distance(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // slower: walks from the start to the goal, each step picking a neighbour that keeps the distance exact
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    const Stats& stats() const noexcept { return m_stats; }
+
+private:
+    // one label entry: hub (as its position in the hub order) and the distance to / from it
+    struct Entry {
+        uint32_t hub;
+        double distance;
+    };
+
+    // start of the label block (and of the file)
+    struct Header {
+        uint32_t magic;
+        int32_t rows;
+        int32_t cols;
+        uint32_t outEntries;
+        uint64_t fingerprint;
+    };
+
+    // points the m_* views into a label block (owned buffer or mapped file), false if the block is inconsistent
+    bool attach(const unsigned char* data, size_t size);
+
+    // distance between two cell indices using the labels
+    double query(int s, int t) const;
+
+    GridGraph m_graph;
+    Stats m_stats;
+
+    // the label block when it was built in memory
+    std::vector<unsigned char> m_buffer;
+    // the mapped file when it was loaded with map()
+    std::unique_ptr<QFile> m_file;
+
+    // views into the label block: out labels of cell v are m_out[m_outOffsets[v] .. m_outOffsets[v + 1]), same for in
+    const unsigned char* m_data = nullptr;
+    const uint32_t* m_outOffsets = nullptr;
+    const uint32_t* m_inOffsets = nullptr;
+    const Entry* m_out = nullptr;
+    const Entry* m_in = nullptr;
+};
+
+#endif // HUBLABELS_H
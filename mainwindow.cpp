@@ -6,6 +6,7 @@
 #include <QPushButton>
 #include <QWidget>
 #include <QRadioButton>
+#include <QCheckBox>
 #include <QMessageBox>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -139,6 +140,30 @@ QWidget* MainWindow::createToolButtons()
             }
         });
 
+    QPushButton *visualizeBtn = new QPushButton("Visualize Search", toolPanel);
+        // connect visualizeBtn to a lamda that animates the A* search itself, cell by cell
+        connect(visualizeBtn, &QPushButton::clicked, this, [this]() {
+            // check if start and goal are set
+            if (m_model->startPosition().first == 101 || m_model->goalPosition().first == 101) {
+                QMessageBox::warning(this, "Error", "Set start and goal positions first!");
+                return;
+            }
+            m_costLabel->setText("Searching...");
+            m_view->visualizeSearch();
+        });
+        // when the animated search is done update the total cost label
+        connect(m_view, &GridView::searchFinished, this, [this](double totalCost) {
+            if (totalCost >= 0) {
+                m_costLabel->setText(QString("Optimal path cost: %1").arg(totalCost, 0, 'f', 2));
+            } else {
+                m_costLabel->setText("No valid path found!");
+            }
+        });
+
+    QCheckBox *distanceBox = new QCheckBox("Show Wall Distance", toolPanel);
+        // tint cells by how close they are to the nearest wall
+        connect(distanceBox, &QCheckBox::toggled, m_view, &GridView::setDistanceOverlay);
+
     // adding all the elements to the layout
     toolLayout->addWidget(normalBtn);
     toolLayout->addWidget(wallBtn);
@@ -149,6 +174,8 @@ QWidget* MainWindow::createToolButtons()
     toolLayout->addSpacing(20);
     toolLayout->addWidget(clearBtn);
     toolLayout->addWidget(pathBtn);
+    toolLayout->addWidget(visualizeBtn);
+    toolLayout->addWidget(distanceBox);
     toolLayout->addStretch();
 
     // returning this layout to be added to the main layout
@@ -0,0 +1,127 @@
+#include "movingtargetsearch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+MovingTargetSearch::MovingTargetSearch(const GridModel& model)
+    : m_graph(model)
+{
+    reset();
+}
+
+void MovingTargetSearch::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    const int cell = m_graph.index(row, col);
+    const double oldCost = m_graph.cost(cell);
+    m_graph.refreshCell(model, row, col);
+    const double newCost = m_graph.cost(cell);
+    // a cheaper cell (or a wall turned into something passable) can make learned values too high
+    if ((oldCost < 0 && newCost >= 0) || (newCost >= 0 && newCost < oldCost)) reset();
+}
+
+void MovingTargetSearch::reset()
+{
+    m_g.assign(m_graph.size(), std::numeric_limits<double>::infinity());
+    m_h.assign(m_graph.size(), 0.0);
+    m_parent.assign(m_graph.size(), -1);
+    m_searchOf.assign(m_graph.size(), 0);
+    m_closedIn.assign(m_graph.size(), 0);
+    // search 0 stands for "never searched"
+    m_pathCost.assign(1, 0.0);
+    m_shift.assign(1, 0.0);
+    m_search = 0;
+    m_goal = -1;
+    m_stats.searches = 0;
+}
+
+double MovingTargetSearch::manhattan(int cell) const
+{
+    const auto [row, col] = m_graph.cell(cell);
+    const auto [goalRow, goalCol] = m_graph.cell(m_goal);
+    return (std::abs(row - goalRow) + std::abs(col - goalCol)) * m_graph.minCost();
+}
+
+void MovingTargetSearch::initializeCell(int cell)
+{
+    const int last = m_searchOf[cell];
+    if (last == m_search) return;
+    if (last == 0) {
+        m_h[cell] = manhattan(cell);
+    } else {
+        // expanded in its last search: its remaining cost to that search's goal is known exactly
+        if (m_closedIn[cell] == last) m_h[cell] = m_pathCost[last] - m_g[cell];
+        // the goal moved since, by at least this much
+        m_h[cell] = std::max(m_h[cell] - (m_shift[m_search] - m_shift[last]), manhattan(cell));
+    }
+    m_g[cell] = std::numeric_limits<double>::infinity();
+    m_searchOf[cell] = m_search;
+}
+
+Pathfinder::PathResult MovingTargetSearch::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal)
+{
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    m_stats.lastExpanded = 0;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (!m_graph.passable(s) || !m_graph.passable(t)) return result;
+
+    // the new goal's learned value (towards the old goal) bounds how much closer any cell can have come
+    double shift = 0.0;
+    if (m_goal >= 0 && t != m_goal) {
+        initializeCell(t);
+        shift = m_h[t];
+        if (m_closedIn[t] == m_search && m_g[t] + m_h[t] < m_pathCost[m_search]) shift = m_pathCost[m_search] - m_g[t];
+    }
+    m_goal = t;
+    ++m_search;
+    ++m_stats.searches;
+    m_shift.push_back(m_shift.back() + shift);
+    m_pathCost.push_back(std::numeric_limits<double>::infinity());
+
+    initializeCell(s);
+    initializeCell(t);
+    m_g[s] = 0.0;
+    m_parent[s] = -1;
+
+    // {f, -g, cell}: lowest f first, deeper cells first on ties
+    std::priority_queue<std::tuple<double, double, int>, std::vector<std::tuple<double, double, int>>, std::greater<>> open;
+    open.push({m_h[s], 0.0, s});
+    while (!open.empty()) {
+        const auto [f, negG, cell] = open.top();
+        open.pop();
+        if (m_closedIn[cell] == m_search || -negG != m_g[cell]) continue;
+        m_closedIn[cell] = m_search;
+        ++m_stats.lastExpanded;
+
+        if (cell == t) {
+            m_pathCost[m_search] = m_g[t];
+            for (int c = t; c != -1; c = m_parent[c]) result.path.push_back(m_graph.cell(c));
+            std::reverse(result.path.begin(), result.path.end());
+            result.totalCost = m_g[t];
+            break;
+        }
+
+        m_graph.forEachNeighbour(cell, [&](int nb, int) {
+            initializeCell(nb);
+            const double g = m_g[cell] + m_graph.cost(nb);
+            if (g < m_g[nb]) {
+                m_g[nb] = g;
+                m_parent[nb] = cell;
+                open.push({g + m_h[nb], -g, nb});
+            }
+        });
+    }
+    m_stats.totalExpanded += m_stats.lastExpanded;
+
+    // without a path the learned values mean nothing for other goals, start over next time
+    if (result.totalCost < 0) reset();
+    return result;
+}
@@ -0,0 +1,66 @@
+#ifndef MOVINGTARGETSEARCH_H
+#define MOVINGTARGETSEARCH_H
+
+#include "gridgraph.h"
+#include "gridmodel.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <vector>
+
+// Repeated A* for chasing a goal that keeps moving (Generalized Adaptive A*).
+// After every search the cells it expanded learn their exact remaining cost (cost of the path found minus their g),
+// which is a much better heuristic than the Manhattan distance for the next search. When the goal moves, the learned
+// values are shifted down by a lower bound on the cost from the new goal to the old one, which keeps them admissible
+// for the new goal. Both corrections are applied lazily when a search first touches a cell, so a goal move costs
+// nothing up front. Start moves need no correction at all. The more the searches overlap (a goal moving a few cells,
+// a pursuer walking along its path) the fewer cells each new search expands.
+// Edits that make the terrain more expensive keep the learned values valid. Cheaper terrain resets them.
+class MovingTargetSearch {
+public:
+    struct Stats {
+        int searches = 0;         // searches since the learned values were last reset
+        int lastExpanded = 0;     // cells expanded by the last findPath()
+        long long totalExpanded = 0;
+    };
+
+    explicit MovingTargetSearch(const GridModel& model);
+
+    // copies one edited cell from the model
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // cheapest path from start to goal. call it again whenever either of them moved, every call reuses what the
+    // earlier ones learned. same result format as Pathfinder::findPath(), throws std::out_of_range for cells outside
+    // the grid
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal);
+
+    // forgets everything learned
+    void reset();
+
+    Stats stats() const { return m_stats; }
+
+private:
+    // brings a cell's g and h up to date for the current search (see the class comment)
+    void initializeCell(int cell);
+
+    // Manhattan distance to the current goal at the cheapest terrain cost
+    double manhattan(int cell) const;
+
+    GridGraph m_graph;
+    int m_goal = -1;
+
+    std::vector<double> m_g;
+    std::vector<double> m_h;
+    std::vector<int> m_parent;
+    std::vector<int> m_searchOf;   // search that last touched the cell, 0 = never
+    std::vector<int> m_closedIn;   // search that expanded the cell
+
+    // per search (index = search number): cost of the path it found and the total shift of the heuristic caused by
+    // goal moves before it
+    std::vector<double> m_pathCost;
+    std::vector<double> m_shift;
+    int m_search = 0;
+
+    Stats m_stats;
+};
+
+#endif // MOVINGTARGETSEARCH_H
@@ -0,0 +1,398 @@
+#include "navmesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+// point in cell centre co-ordinates (x = column, y = row) used by the funnel algorithm
+struct Point {
+    double x;
+    double y;
+};
+
+double cross(const Point& a, const Point& b, const Point& origin)
+{
+    return (a.x - origin.x) * (b.y - origin.y) - (a.y - origin.y) * (b.x - origin.x);
+}
+
+bool samePoint(const Point& a, const Point& b)
+{
+    return std::abs(a.x - b.x) < 1e-9 && std::abs(a.y - b.y) < 1e-9;
+}
+}
+
+NavMesh::NavMesh(const GridModel& model, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    m_tileRows = (m_graph.rowCount() + kTileSize - 1) / kTileSize;
+    m_tileCols = (m_graph.colCount() + kTileSize - 1) / kTileSize;
+    m_rectOf.assign(m_graph.size(), -1);
+    m_tileRects.resize(m_tileRows * m_tileCols);
+    for (int tile = 0; tile < m_tileRows * m_tileCols; ++tile) decomposeTile(tile);
+
+    // every pair of touching rectangles once: along the bottom and right side of the upper / left one
+    for (int rect = 0; rect < static_cast<int>(m_rects.size()); ++rect) addPortals(rect, false);
+}
+
+void NavMesh::decomposeTile(int tile)
+{
+    const int cols = m_graph.colCount();
+    const int top = (tile / m_tileCols) * kTileSize;
+    const int left = (tile % m_tileCols) * kTileSize;
+    const int bottom = std::min(top + kTileSize, m_graph.rowCount()) - 1;
+    const int right = std::min(left + kTileSize, cols) - 1;
+
+    // same greedy cover as RectangularSymmetryReduction::decompose(), but never leaving the tile
+    auto usable = [&](int row, int col, double cost) {
+        const int cell = row * cols + col;
+        return m_graph.passable(cell) && m_rectOf[cell] == -1 && m_graph.cost(cell) == cost;
+    };
+    auto rowUsable = [&](int row, int from, int to, double cost) {
+        for (int col = from; col <= to; ++col) {
+            if (!usable(row, col, cost)) return false;
+        }
+        return true;
+    };
+    auto colUsable = [&](int col, int from, int to, double cost) {
+        for (int row = from; row <= to; ++row) {
+            if (!usable(row, col, cost)) return false;
+        }
+        return true;
+    };
+
+    for (int row = top; row <= bottom; ++row) {
+        for (int col = left; col <= right; ++col) {
+            const int seed = row * cols + col;
+            if (!m_graph.passable(seed) || m_rectOf[seed] != -1) continue;
+            const double cost = m_graph.cost(seed);
+
+            int wideRight = col;
+            while (wideRight + 1 <= right && usable(row, wideRight + 1, cost)) ++wideRight;
+            int wideBottom = row;
+            while (wideBottom + 1 <= bottom && rowUsable(wideBottom + 1, col, wideRight, cost)) ++wideBottom;
+
+            int tallBottom = row;
+            while (tallBottom + 1 <= bottom && usable(tallBottom + 1, col, cost)) ++tallBottom;
+            int tallRight = col;
+            while (tallRight + 1 <= right && colUsable(tallRight + 1, row, tallBottom, cost)) ++tallRight;
+
+            Rect rect {static_cast<uint8_t>(row), static_cast<uint8_t>(col), 0, 0, cost, tile, {}};
+            if ((wideRight - col + 1) * (wideBottom - row + 1) >= (tallRight - col + 1) * (tallBottom - row + 1)) {
+                rect.bottom = static_cast<uint8_t>(wideBottom);
+                rect.right = static_cast<uint8_t>(wideRight);
+            } else {
+                rect.bottom = static_cast<uint8_t>(tallBottom);
+                rect.right = static_cast<uint8_t>(tallRight);
+            }
+
+            int id;
+            if (!m_freeRects.empty()) {
+                id = m_freeRects.back();
+                m_freeRects.pop_back();
+                m_rects[id] = std::move(rect);
+            } else {
+                id = static_cast<int>(m_rects.size());
+                m_rects.push_back(std::move(rect));
+            }
+            m_tileRects[tile].push_back(id);
+            for (int r = m_rects[id].top; r <= m_rects[id].bottom; ++r) {
+                for (int c = m_rects[id].left; c <= m_rects[id].right; ++c) m_rectOf[r * cols + c] = id;
+            }
+        }
+    }
+}
+
+void NavMesh::clearTile(int tile)
+{
+    for (int id : m_tileRects[tile]) {
+        Rect& rect = m_rects[id];
+        for (int portal : rect.portals) {
+            Portal& p = m_portals[portal];
+            if (p.first == -1) continue;  // shared with a rectangle of this tile that was cleared already
+            const int other = p.first == id ? p.second : p.first;
+            auto& otherPortals = m_rects[other].portals;
+            otherPortals.erase(std::find(otherPortals.begin(), otherPortals.end(), portal));
+            p.first = p.second = -1;
+            m_freePortals.push_back(portal);
+        }
+        rect.portals.clear();
+        for (int r = rect.top; r <= rect.bottom; ++r) {
+            for (int c = rect.left; c <= rect.right; ++c) m_rectOf[m_graph.index(r, c)] = -1;
+        }
+        // mark as removed (top > bottom) and free the slot
+        rect.top = 1;
+        rect.bottom = 0;
+        m_freeRects.push_back(id);
+    }
+    m_tileRects[tile].clear();
+}
+
+void NavMesh::addPortals(int rect, bool topAndLeft)
+{
+    const Rect& r = m_rects[rect];
+    if (r.top > r.bottom) return;
+    const int rows = m_graph.rowCount();
+    const int cols = m_graph.colCount();
+
+    // walks along one side just outside the rectangle and adds a portal for each run of cells of one neighbour
+    auto scan = [&](bool vertical, bool before, int outside, int from, int to) {
+        if (outside < 0 || outside >= (vertical ? cols : rows)) return;
+        for (int along = from; along <= to;) {
+            const int other = m_rectOf[vertical ? m_graph.index(along, outside) : m_graph.index(outside, along)];
+            if (other < 0) {
+                ++along;
+                continue;
+            }
+            int end = along;
+            while (end + 1 <= to && m_rectOf[vertical ? m_graph.index(end + 1, outside) : m_graph.index(outside, end + 1)] == other) ++end;
+
+            // along the top / left side only towards other tiles (rectangles of the same tile add those themselves)
+            if (!before || m_rects[other].tile != r.tile) {
+                Portal portal {before ? other : rect, before ? rect : other, vertical,
+                               static_cast<uint8_t>(before ? outside + 1 : outside), static_cast<uint8_t>(along), static_cast<uint8_t>(end)};
+                int id;
+                if (!m_freePortals.empty()) {
+                    id = m_freePortals.back();
+                    m_freePortals.pop_back();
+                    m_portals[id] = portal;
+                } else {
+                    id = static_cast<int>(m_portals.size());
+                    m_portals.push_back(portal);
+                }
+                m_rects[rect].portals.push_back(id);
+                m_rects[other].portals.push_back(id);
+            }
+            along = end + 1;
+        }
+    };
+
+    if (topAndLeft) {
+        scan(false, true, r.top - 1, r.left, r.right);
+        scan(true, true, r.left - 1, r.top, r.bottom);
+    }
+    scan(false, false, r.bottom + 1, r.left, r.right);
+    scan(true, false, r.right + 1, r.top, r.bottom);
+}
+
+void NavMesh::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    m_graph.refreshCell(model, row, col);
+    const int tile = (row / kTileSize) * m_tileCols + col / kTileSize;
+    clearTile(tile);
+    decomposeTile(tile);
+    for (int rect : m_tileRects[tile]) addPortals(rect, true);
+}
+
+std::pair<uint8_t, uint8_t> NavMesh::portalCell(const Portal& portal, int rect, int along) const
+{
+    const int line = rect == portal.first ? portal.line - 1 : portal.line;
+    if (portal.vertical) return {static_cast<uint8_t>(along), static_cast<uint8_t>(line)};
+    return {static_cast<uint8_t>(line), static_cast<uint8_t>(along)};
+}
+
+std::vector<int> NavMesh::pullString(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal,
+                                     const std::vector<int>& portals, const std::vector<int>& rects) const
+{
+    // funnel entries: start, every portal as a (left, right) pair seen in the direction of travel, goal
+    const int count = static_cast<int>(portals.size());
+    const Point startPoint {static_cast<double>(start.second), static_cast<double>(start.first)};
+    const Point goalPoint {static_cast<double>(goal.second), static_cast<double>(goal.first)};
+    std::vector<std::pair<Point, Point>> funnel;
+    funnel.reserve(count + 2);
+    funnel.push_back({startPoint, startPoint});
+    for (int i = 0; i < count; ++i) {
+        const Portal& portal = m_portals[portals[i]];
+        const double line = portal.line - 0.5;
+        Point a = portal.vertical ? Point {line, static_cast<double>(portal.from)} : Point {static_cast<double>(portal.from), line};
+        Point b = portal.vertical ? Point {line, static_cast<double>(portal.to)} : Point {static_cast<double>(portal.to), line};
+        const double sign = rects[i] == portal.first ? 1.0 : -1.0;
+        const Point direction = portal.vertical ? Point {sign, 0.0} : Point {0.0, sign};
+        const Point middle {(a.x + b.x) / 2.0, (a.y + b.y) / 2.0};
+        // left = the end on the positive side of the direction of travel
+        if (cross(direction, Point {a.x - middle.x, a.y - middle.y}, Point {0.0, 0.0}) < 0) std::swap(a, b);
+        funnel.push_back({a, b});
+    }
+    funnel.push_back({goalPoint, goalPoint});
+
+    // simple stupid funnel algorithm: narrow the funnel portal by portal, and whenever one side crosses over the
+    // other, the path bends around that corner, which becomes the new apex
+    std::vector<std::pair<Point, int>> bends {{startPoint, 0}};
+    Point apex = startPoint, left = startPoint, right = startPoint;
+    int apexIndex = 0, leftIndex = 0, rightIndex = 0;
+    for (int i = 1; i <= count + 1; ++i) {
+        const Point& newLeft = funnel[i].first;
+        const Point& newRight = funnel[i].second;
+
+        if (cross(right, newRight, apex) >= 0) {
+            if (samePoint(apex, right) || cross(left, newRight, apex) < 0) {
+                right = newRight;
+                rightIndex = i;
+            } else {
+                apex = left;
+                apexIndex = leftIndex;
+                bends.push_back({apex, apexIndex});
+                right = apex;
+                rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+        if (cross(left, newLeft, apex) <= 0) {
+            if (samePoint(apex, left) || cross(right, newLeft, apex) > 0) {
+                left = newLeft;
+                leftIndex = i;
+            } else {
+                apex = right;
+                apexIndex = rightIndex;
+                bends.push_back({apex, apexIndex});
+                left = apex;
+                leftIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+    bends.push_back({goalPoint, count + 1});
+
+    // where the pulled string crosses each portal, rounded to a cell of the portal
+    std::vector<int> crossings(count);
+    size_t bend = 0;
+    for (int i = 1; i <= count; ++i) {
+        while (bends[bend + 1].second < i) ++bend;
+        const Portal& portal = m_portals[portals[i - 1]];
+        const Point& a = bends[bend].first;
+        const Point& b = bends[bend + 1].first;
+        double along;
+        if (bends[bend + 1].second == i) {
+            along = portal.vertical ? b.y : b.x;
+        } else {
+            const double line = portal.line - 0.5;
+            const double t = portal.vertical ? (line - a.x) / (b.x - a.x) : (line - a.y) / (b.y - a.y);
+            along = portal.vertical ? a.y + t * (b.y - a.y) : a.x + t * (b.x - a.x);
+            if (!std::isfinite(along)) along = (portal.from + portal.to) / 2.0;
+        }
+        crossings[i - 1] = std::clamp(static_cast<int>(std::lround(along)), static_cast<int>(portal.from), static_cast<int>(portal.to));
+    }
+    return crossings;
+}
+
+Pathfinder::PathResult NavMesh::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal)
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    m_lastExpansions = 0;
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return result;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (!m_graph.passable(s) || !m_graph.passable(t)) return result;
+
+    const int startRect = m_rectOf[s];
+    const int goalRect = m_rectOf[t];
+    auto manhattan = [](std::pair<uint8_t, uint8_t> a, std::pair<uint8_t, uint8_t> b) {
+        return std::abs(a.first - b.first) + std::abs(a.second - b.second);
+    };
+
+    // walks from one cell to another of the same rectangle, rows first (stays inside the rectangle)
+    auto walk = [&](std::pair<uint8_t, uint8_t> from, std::pair<uint8_t, uint8_t> to) {
+        while (from.first != to.first) {
+            from.first += to.first > from.first ? 1 : -1;
+            result.path.push_back(from);
+        }
+        while (from.second != to.second) {
+            from.second += to.second > from.second ? 1 : -1;
+            result.path.push_back(from);
+        }
+    };
+
+    std::vector<int> routePortals;
+    std::vector<int> routeRects {startRect};
+    if (startRect != goalRect) {
+        // A* over portal crossings. node = portal * 2 + side, standing on the middle cell of the portal on the
+        // first (0) or second (1) rectangle's side
+        const size_t nodeCount = m_portals.size() * 2;
+        const double minCost = m_graph.minCost();
+        std::vector<double> g(nodeCount, std::numeric_limits<double>::infinity());
+        std::vector<int> parent(nodeCount, -1);
+        std::vector<char> closed(nodeCount, 0);
+        std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+
+        auto middle = [&](int portal, int rect) {
+            const Portal& p = m_portals[portal];
+            return portalCell(p, rect, (p.from + p.to) / 2);
+        };
+        auto relax = [&](int from, int portal, int rect, double cost, std::pair<uint8_t, uint8_t> fromCell) {
+            // move to the portal inside this rectangle, then step across it
+            const Portal& p = m_portals[portal];
+            const int other = p.first == rect ? p.second : p.first;
+            const int node = portal * 2 + (p.first == rect ? 1 : 0);
+            const double newCost = cost + manhattan(fromCell, middle(portal, rect)) * m_rects[rect].cost + m_rects[other].cost;
+            if (newCost < g[node]) {
+                g[node] = newCost;
+                parent[node] = from;
+                queue.push({newCost + manhattan(middle(portal, other), goal) * minCost, node});
+            }
+        };
+
+        for (int portal : m_rects[startRect].portals) relax(-1, portal, startRect, 0.0, start);
+        double best = std::numeric_limits<double>::infinity();
+        int bestNode = -1;
+        while (!queue.empty()) {
+            const auto [f, node] = queue.top();
+            queue.pop();
+            if (f >= best) break;
+            if (closed[node]) continue;
+            closed[node] = 1;
+            ++m_lastExpansions;
+
+            const int portal = node / 2;
+            const int rect = node % 2 ? m_portals[portal].second : m_portals[portal].first;
+            const auto cell = middle(portal, rect);
+            if (rect == goalRect) {
+                const double cost = g[node] + manhattan(cell, goal) * m_rects[rect].cost;
+                if (cost < best) {
+                    best = cost;
+                    bestNode = node;
+                }
+            }
+            for (int next : m_rects[rect].portals) {
+                if (next != portal) relax(node, next, rect, g[node], cell);
+            }
+        }
+        if (bestNode < 0) return result;
+
+        for (int node = bestNode; node != -1; node = parent[node]) routePortals.push_back(node / 2);
+        std::reverse(routePortals.begin(), routePortals.end());
+        for (int portal : routePortals) {
+            const Portal& p = m_portals[portal];
+            routeRects.push_back(p.first == routeRects.back() ? p.second : p.first);
+        }
+    }
+
+    // pull the route tight and walk it: inside each rectangle to the crossing cell, then across the portal
+    const std::vector<int> crossings = pullString(start, goal, routePortals, routeRects);
+    result.path.push_back(start);
+    for (size_t i = 0; i < routePortals.size(); ++i) {
+        const Portal& portal = m_portals[routePortals[i]];
+        walk(result.path.back(), portalCell(portal, routeRects[i], crossings[i]));
+        result.path.push_back(portalCell(portal, routeRects[i + 1], crossings[i]));
+    }
+    walk(result.path.back(), goal);
+
+    result.totalCost = 0.0;
+    for (size_t i = 1; i < result.path.size(); ++i) result.totalCost += m_graph.cost(m_graph.index(result.path[i]));
+    return result;
+}
+
+NavMesh::Stats NavMesh::stats() const
+{
+    Stats stats;
+    stats.tiles = m_tileRows * m_tileCols;
+    for (const Rect& rect : m_rects) stats.rectangles += rect.top <= rect.bottom;
+    for (const Portal& portal : m_portals) stats.portals += portal.first >= 0;
+    stats.lastExpansions = m_lastExpansions;
+    return stats;
+}
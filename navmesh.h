@@ -0,0 +1,102 @@
+#ifndef NAVMESH_H
+#define NAVMESH_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <vector>
+
+// Rectangle navigation mesh.
+// The grid is cut into square tiles and the passable cells of each tile into rectangles of one terrain type. Any two
+// rectangles that touch share a portal (the stretch of border where a move from one into the other is possible).
+// findPath() runs A* over the portals instead of the cells, then pulls the route tight with the funnel algorithm and
+// walks it cell by cell, so long paths cost a few hundred node expansions instead of tens of thousands. Paths are
+// always valid, but like any navmesh route they can be slightly more expensive than the cheapest grid path.
+// An edit only rebuilds the rectangles of its own tile and the portals around them (cellChanged()).
+class NavMesh {
+public:
+    // side length of a tile in cells
+    static constexpr int kTileSize = 16;
+
+    // inclusive bounds of a rectangle of one terrain type (top > bottom for removed entries)
+    struct Rect {
+        uint8_t top;
+        uint8_t left;
+        uint8_t bottom;
+        uint8_t right;
+        double cost;               // terrain cost of every cell in it
+        int tile;
+        std::vector<int> portals;  // portals on its border
+    };
+
+    // shared border of two rectangles. "first" is the rectangle above (horizontal border) or to the left (vertical border).
+    // a move across the portal goes from (line - 1) to line in rows (horizontal) or columns (vertical), anywhere in
+    // [from, to] along the border. removed entries have first == -1
+    struct Portal {
+        int first;
+        int second;
+        bool vertical;
+        uint8_t line;
+        uint8_t from;
+        uint8_t to;
+    };
+
+    struct Stats {
+        int tiles = 0;
+        int rectangles = 0;
+        int portals = 0;
+        int lastExpansions = 0;  // portal nodes expanded by the last findPath() call
+    };
+
+    // builds the whole mesh, rectangles and portal costs follow the profile (build one per profile)
+    explicit NavMesh(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // rebuilds the tile of the edited cell
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // A* over portals plus funnel smoothing, same result format as Pathfinder::findPath()
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal);
+
+    // rectangle a cell belongs to, or -1 for walls
+    int rectOf(uint8_t row, uint8_t col) const { return m_rectOf[m_graph.index(row, col)]; }
+
+    const std::vector<Rect>& rects() const noexcept { return m_rects; }
+    const std::vector<Portal>& portals() const noexcept { return m_portals; }
+
+    Stats stats() const;
+
+private:
+    // cuts the passable cells of one tile into rectangles
+    void decomposeTile(int tile);
+
+    // removes the rectangles of one tile together with every portal touching them
+    void clearTile(int tile);
+
+    // adds the portals along the given sides of a rectangle (0 = top, 1 = bottom, 2 = left, 3 = right)
+    void addPortals(int rect, bool topAndLeft);
+
+    // cell on the given rectangle's side of a portal, at position "along" the border
+    std::pair<uint8_t, uint8_t> portalCell(const Portal& portal, int rect, int along) const;
+
+    // chooses where the route crosses each portal (funnel algorithm), returns one position along each border
+    std::vector<int> pullString(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal,
+                                const std::vector<int>& portals, const std::vector<int>& rects) const;
+
+    GridGraph m_graph;
+    int m_tileRows = 0;
+    int m_tileCols = 0;
+
+    // rectangle index of every cell (-1 for walls)
+    std::vector<int> m_rectOf;
+    std::vector<Rect> m_rects;
+    std::vector<Portal> m_portals;
+
+    // rectangles of every tile, and removed slots that can be reused
+    std::vector<std::vector<int>> m_tileRects;
+    std::vector<int> m_freeRects;
+    std::vector<int> m_freePortals;
+
+    int m_lastExpansions = 0;
+};
+
+#endif // NAVMESH_H
@@ -0,0 +1,167 @@
+#include "nearesttargetsearch.h"
+#include "pathfinder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+constexpr int dr[4] = {-1, 1, 0, 0};
+constexpr int dc[4] = {0, 0, -1, 1};
+
+using QueueEntry = std::pair<double, int>;
+using MinQueue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>>;
+}
+
+NearestTargetSearch::NearestTargetSearch(const GridModel& model)
+    : m_model(model)
+{
+}
+
+double NearestTargetSearch::cost(int cell) const
+{
+    return Pathfinder::getCost(m_model.cellState(cell / m_model.colCount(), cell % m_model.colCount()));
+}
+
+NearestTargetSearch::Result NearestTargetSearch::findNearest(const std::pair<uint8_t, uint8_t>& start,
+                                                             const std::vector<std::pair<uint8_t, uint8_t>>& targets) const
+{
+    const int rows = m_model.rowCount();
+    const int cols = m_model.colCount();
+    if (start.first >= rows || start.second >= cols || cost(start.first * cols + start.second) < 0) return {};
+
+    // index of the first target at every cell (-1 if none), skipping walls, duplicates and cells outside the grid
+    std::vector<int> targetAt(rows * cols, -1);
+    std::vector<int> cells;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (targets[i].first >= rows || targets[i].second >= cols) continue;
+        const int cell = targets[i].first * cols + targets[i].second;
+        if (cost(cell) < 0 || targetAt[cell] >= 0) continue;
+        targetAt[cell] = static_cast<int>(i);
+        cells.push_back(cell);
+    }
+    if (cells.empty()) return {};
+
+    const int s = start.first * cols + start.second;
+    if (targetAt[s] >= 0) {
+        Result result;
+        result.path.push_back(start);
+        result.totalCost = 0.0;
+        result.targetIndex = targetAt[s];
+        return result;
+    }
+    return cells.size() <= kReverseThreshold ? searchForward(s, cells, targetAt) : searchBackward(s, cells, targetAt);
+}
+
+NearestTargetSearch::Result NearestTargetSearch::searchForward(int start, const std::vector<int>& targets,
+                                                               const std::vector<int>& targetAt) const
+{
+    const int cols = m_model.colCount();
+    const int n = m_model.rowCount() * cols;
+    const double minCost = Pathfinder::getCost(GridModel::Boost);
+
+    // smallest Manhattan distance to any target (a minimum of consistent heuristics is consistent)
+    auto heuristic = [&](int cell) {
+        int best = std::numeric_limits<int>::max();
+        for (int target : targets) {
+            best = std::min(best, std::abs(cell / cols - target / cols) + std::abs(cell % cols - target % cols));
+        }
+        return best * minCost;
+    };
+
+    Result result;
+    std::vector<double> g(n, std::numeric_limits<double>::infinity());
+    std::vector<int> parent(n, -1);
+    std::vector<char> closed(n, 0);
+    MinQueue queue;
+    g[start] = 0.0;
+    queue.push({heuristic(start), start});
+    while (!queue.empty()) {
+        const int current = queue.top().second;
+        queue.pop();
+        if (closed[current]) continue;
+        closed[current] = 1;
+        ++result.expanded;
+
+        // the first target taken off the queue is the cheapest one
+        if (targetAt[current] >= 0) {
+            for (int cell = current; cell != -1; cell = parent[cell]) result.path.push_back({static_cast<uint8_t>(cell / cols), static_cast<uint8_t>(cell % cols)});
+            std::reverse(result.path.begin(), result.path.end());
+            result.totalCost = g[current];
+            result.targetIndex = targetAt[current];
+            return result;
+        }
+
+        const int row = current / cols;
+        const int col = current % cols;
+        for (int direction = 0; direction < 4; ++direction) {
+            const int nr = row + dr[direction];
+            const int nc = col + dc[direction];
+            if (nr < 0 || nr >= m_model.rowCount() || nc < 0 || nc >= cols) continue;
+            const int next = nr * cols + nc;
+            const double stepCost = cost(next);
+            if (stepCost < 0 || g[current] + stepCost >= g[next]) continue;
+            g[next] = g[current] + stepCost;
+            parent[next] = current;
+            queue.push({g[next] + heuristic(next), next});
+        }
+    }
+    return result;
+}
+
+NearestTargetSearch::Result NearestTargetSearch::searchBackward(int start, const std::vector<int>& targets,
+                                                                const std::vector<int>& targetAt) const
+{
+    const int cols = m_model.colCount();
+    const int n = m_model.rowCount() * cols;
+    const double minCost = Pathfinder::getCost(GridModel::Boost);
+    const int startRow = start / cols;
+    const int startCol = start % cols;
+    auto heuristic = [&](int cell) {
+        return (std::abs(cell / cols - startRow) + std::abs(cell % cols - startCol)) * minCost;
+    };
+
+    // dist[cell] = cheapest cost from the cell to its nearest target, next[cell] = first step of that path.
+    // moving backwards from a cell to a neighbour costs what moving forwards from the neighbour into the cell costs.
+    Result result;
+    std::vector<double> dist(n, std::numeric_limits<double>::infinity());
+    std::vector<int> next(n, -1);
+    std::vector<char> closed(n, 0);
+    MinQueue queue;
+    for (int target : targets) {
+        dist[target] = 0.0;
+        queue.push({heuristic(target), target});
+    }
+    while (!queue.empty()) {
+        const int current = queue.top().second;
+        queue.pop();
+        if (closed[current]) continue;
+        closed[current] = 1;
+        ++result.expanded;
+
+        if (current == start) {
+            int cell = start;
+            for (; next[cell] != -1; cell = next[cell]) result.path.push_back({static_cast<uint8_t>(cell / cols), static_cast<uint8_t>(cell % cols)});
+            result.path.push_back({static_cast<uint8_t>(cell / cols), static_cast<uint8_t>(cell % cols)});
+            result.totalCost = dist[start];
+            result.targetIndex = targetAt[cell];
+            return result;
+        }
+
+        const double stepCost = cost(current);
+        const int row = current / cols;
+        const int col = current % cols;
+        for (int direction = 0; direction < 4; ++direction) {
+            const int nr = row + dr[direction];
+            const int nc = col + dc[direction];
+            if (nr < 0 || nr >= m_model.rowCount() || nc < 0 || nc >= cols) continue;
+            const int previous = nr * cols + nc;
+            if (cost(previous) < 0 || dist[current] + stepCost >= dist[previous]) continue;
+            dist[previous] = dist[current] + stepCost;
+            next[previous] = current;
+            queue.push({dist[previous] + heuristic(previous), previous});
+        }
+    }
+    return result;
+}
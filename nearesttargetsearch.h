@@ -0,0 +1,42 @@
+#ifndef NEARESTTARGETSEARCH_H
+#define NEARESTTARGETSEARCH_H
+
+#include "gridmodel.h"
+#include <cstdint>
+#include <vector>
+
+// Search for the cheapest of several goals in one run.
+// Instead of one findPath() per target, a single search stops at whichever target it reaches first:
+//   - few targets: forward A* from the start with the smallest Manhattan distance to any target as heuristic.
+//   - many targets: the min-over-targets heuristic gets expensive, so the search runs backwards instead, starting
+//     from all targets at once and heading for the start (a single target again, with a plain Manhattan heuristic).
+// Both use the same move costs as Pathfinder (entering a cell costs its terrain) and return the same path.
+// Reads the model directly, so there is nothing to build or keep up to date.
+class NearestTargetSearch {
+public:
+    // at most this many targets are searched forwards, more are searched backwards
+    static constexpr size_t kReverseThreshold = 16;
+
+    struct Result {
+        std::vector<std::pair<uint8_t, uint8_t>> path;  // start ... target
+        double totalCost = -1;                          // -1 if no target can be reached
+        int targetIndex = -1;                           // index into the targets passed to findNearest()
+        int expanded = 0;                               // cells expanded by the search
+    };
+
+    explicit NearestTargetSearch(const GridModel& model);
+
+    // cheapest path from start to any of the targets. targets that are walls or outside of the grid are ignored
+    Result findNearest(const std::pair<uint8_t, uint8_t>& start, const std::vector<std::pair<uint8_t, uint8_t>>& targets) const;
+
+private:
+    Result searchForward(int start, const std::vector<int>& targets, const std::vector<int>& targetAt) const;
+    Result searchBackward(int start, const std::vector<int>& targets, const std::vector<int>& targetAt) const;
+
+    // cost of moving into a cell (-1 for walls), cells numbered row * cols + col
+    double cost(int cell) const;
+
+    const GridModel& m_model;
+};
+
+#endif // NEARESTTARGETSEARCH_H
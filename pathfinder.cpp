@@ -1,32 +1,124 @@
 #include "pathfinder.h"
+#include "goalbounding.h"
 #include <algorithm>
+#include <array>
 
 Pathfinder::Pathfinder(const GridModel& model) : m_model(model) {}
 
 Pathfinder::PathResult Pathfinder::findPath() {
-    // this is the result to be returned from this function {path, cost_of_path}
-    PathResult result;
+    // return empty path if either the goal or start position is not set
+    if (!beginSearch()) return {};
+
+    // the node expanded by the latest step
+    Node current;
+
+    // process nodes in order of their priority (lowest f values first) until the goal is reached or the queue runs empty.
+    // the empty lambda means no one is listening for discovered nodes, so it is optimized away entirely.
+    while (true) {
+        const StepStatus status = step(current, [](uint8_t, uint8_t, double) {});
+        if (status == StepStatus::GoalReached || status == StepStatus::Exhausted) return m_result;
+    }
+}
+
+Generator<Pathfinder::SearchEvent> Pathfinder::searchEvents() {
+    // nothing to search if either the goal or start position is not set
+    if (!beginSearch()) {
+        m_result = {};
+        m_result.totalCost = -1;
+        co_yield SearchEvent{SearchEvent::Finished, 101, 101, -1.0};
+        co_return;
+    }
+
+    // neighbours discovered during the current step, collected by the lambda and yielded after the step
+    std::vector<SearchEvent> discovered;
+
+    // the node expanded by the latest step
+    Node current;
+
+    while (true) {
+        // clear events from the previous step, the vector keeps its capacity so this doesnt allocate again
+        discovered.clear();
+
+        // run exactly the same step as findPath(), but record every improved neighbour
+        const StepStatus status = step(current, [&discovered](uint8_t row, uint8_t col, double g) {
+            discovered.push_back({SearchEvent::Discovered, row, col, g});
+        });
 
+        // stale queue entries do no work, so there is nothing to show for them
+        if (status == StepStatus::Skipped) continue;
+
+        // goal reached or no path, report the end of the search (the path is in lastResult())
+        if (status == StepStatus::GoalReached) {
+            co_yield SearchEvent{SearchEvent::Finished, current.row, current.col, current.g};
+            co_return;
+        }
+        if (status == StepStatus::Exhausted) {
+            co_yield SearchEvent{SearchEvent::Finished, 101, 101, -1.0};
+            co_return;
+        }
+
+        // the expanded node first, then the neighbours it pushed onto the queue
+        co_yield SearchEvent{SearchEvent::Expanded, current.row, current.col, current.g};
+        for (const auto& event : discovered) {
+            co_yield event;
+        }
+    }
+}
+
+bool Pathfinder::beginSearch() {
     // initialzie start/goal positions from GridModel object
     const auto start = m_model.startPosition();
     const auto goal = m_model.goalPosition();
 
-    // return empty path if either the goal or start position is not set
-    if (start.first == 101 || goal.first == 101) return {};
+    // cant search if either the goal or start position is not set
+    if (start.first == 101 || goal.first == 101) return false;
 
     // clear previous paths data and reset to calculate new path
     initialize();
 
+    // only prune with goal bounding boxes that belong to the current terrain (and only for single cell agents, the boxes
+    // dont know about paths that have to go around narrow gaps)
+    const bool singleCell = m_agentSize == 1;
+    m_activeGoalBounding = (singleCell && m_goalBounding && m_goalBounding->isUpToDate(m_model)
+                            && m_goalBounding->profile().sameCosts(m_profile)) ? m_goalBounding : nullptr;
+
+    // same for dead ends and swamps
+    m_activeRegionPruning = (singleCell && m_regionPruning && m_regionPruning->isUpToDate(m_model)
+                             && m_regionPruning->profile().sameCosts(m_profile)) ? m_regionPruning : nullptr;
+    if (m_activeRegionPruning) m_regionQuery = m_activeRegionPruning->prepare(start, goal);
+
+    // coarse distances from the goal for the heuristic (the block annotations are only rebuilt after terrain edits)
+    m_abstraction.prepare(m_model, goal, m_profile);
+    m_boostHeuristic.prepare(m_model, goal, m_profile);
+
     // break up the std::pair for starting position into row and column
     const uint8_t start_row = start.first;
     const uint8_t start_col = start.second;
 
+    // an agent that doesnt fit on the start or goal has no path, leaving the queue empty makes the first step report that
+    if (m_model.clearance(start_row, start_col) < m_agentSize || m_model.clearance(goal.first, goal.second) < m_agentSize) return true;
+
     // initialize start node to be 0.0 cost (since it doesnt move from start -> start)
     m_costGrid[start_row][start_col] = 0.0;
 
     // add this starting node to priority queue {row, col, g, f = g + h}
     m_queue.push({start_row, start_col, 0.0, heuristic(start_row, start_col)});
 
+    return true;
+}
+
+template <typename OnDiscover>
+Pathfinder::StepStatus Pathfinder::step(Node& current, OnDiscover&& onDiscover) {
+    // if there is nothing left to explore then there is no path
+    if (m_queue.empty()) {
+        m_result.path.clear();
+        m_result.totalCost = -1; // Indicate no path with cost -1
+        return StepStatus::Exhausted;
+    }
+
+    // save the position of the goal
+    const auto goal = m_model.goalPosition();
+
     // Movement directions.
     // delta-row, moving up is -1 and moving down is +1.
     // row changes dont effect right and left so they are 0
@@ -40,76 +132,82 @@ Pathfinder::PathResult Pathfinder::findPath() {
         constexpr is used to initialize values at compile time not runtime, so its more optimized.
     */
 
-    // process nodes in order of their priority (lowest f values first)
-    while (!m_queue.empty()) {
-        // extract the highest priority Node
-        const Node current = m_queue.top();
+    // extract the highest priority Node
+    current = m_queue.top();
 
-        // then remove that highest priority node from the queue
-        m_queue.pop();
+    // then remove that highest priority node from the queue
+    m_queue.pop();
 
-        // if the current node has already been visited, skip this iteration of the while loop (continue)
-        // e.g is queue has 2 entries for same node (3, 5) the least one (3) is processed first and the second one (5) should be skipped
-        if (m_visited[current.row][current.col]) continue;
+    // if the current node has already been visited, skip it
+    // e.g is queue has 2 entries for same node (3, 5) the least one (3) is processed first and the second one (5) should be skipped
+    if (m_visited[current.row][current.col]) return StepStatus::Skipped;
 
-        // if the current node has not been processed yet, mark it as processed now (we are going to process it now in this loop)
-        m_visited[current.row][current.col] = true;
+    // if the current node has not been processed yet, mark it as processed now (we are going to process it now)
+    m_visited[current.row][current.col] = true;
 
-        // early exit if goal is reached
-        if (current.row == goal.first && current.col == goal.second) {
-            // construst the PathResult object
-            result.path = reconstructPath(goal);
-            result.totalCost = m_costGrid[goal.first][goal.second];
-            // return this PathResult object
-            return result;
-        }
+    // early exit if goal is reached
+    if (current.row == goal.first && current.col == goal.second) {
+        // construst the PathResult object
+        m_result.path = reconstructPath(goal);
+        m_result.totalCost = m_costGrid[goal.first][goal.second];
+        return StepStatus::GoalReached;
+    }
+
+    // explore all neighbors.
+    // use size_t as the limit for loop is dr.size() so we want our index to be same type.
+    // using auto/int will give compiler warning for implicit conversions.
+    for (size_t i = 0; i < dr.size(); ++i) {
+        // calculate neighbour co-ordinates.
+        // cant use uint_8, as we need negative numbers to check boundaries.
+        const int nr = current.row + dr[i]; // new row
+        const int nc = current.col + dc[i]; // new column
+
+        // boundary check to see if current neighbour is within the grid, if it is not then continue to next neighbour.
+        if (nr < 0 || nr >= m_model.rowCount() || nc < 0 || nc >= m_model.colCount()) continue;
+
+        // goal bounding: skip this move if no cheapest path to the goal starts with it.
+        if (m_activeGoalBounding && !m_activeGoalBounding->mayLeadTo(current.row, current.col, static_cast<int>(i), goal)) continue;
+
+        // region pruning: skip dead ends and swamps that hold neither the start nor the goal.
+        if (m_activeRegionPruning && m_activeRegionPruning->canSkip(m_regionQuery, nr, nc)) continue;
 
-        // explore all neighbors.
-        // use size_t as the limit for loop is dr.size() so we want our index to be same type.
-        // using auto/int will give compiler warning for implicit conversions.
-        for (size_t i = 0; i < dr.size(); ++i) {
-            // calculate neighbour co-ordinates.
-            // cant use uint_8, as we need negative numbers to check boundaries.
-            const int nr = current.row + dr[i]; // new row
-            const int nc = current.col + dc[i]; // new column
+        // get the type of cell of the current neighbour.
+        const auto cellType = m_model.cellState(nr, nc);
 
-            // boundary check to see if current neighbour is within the grid, if it is not then continue to next neighbour.
-            if (nr < 0 || nr >= m_model.rowCount() || nc < 0 || nc >= m_model.colCount()) continue;
+        // get the movement cost of that neighbour cell for this agent's profile.
+        const double stepCost = m_profile.cost(cellType);
 
-            // get the type of cell of the current neighbour.
-            const auto cellType = m_model.cellState(nr, nc);
+        // if the movement cost is < 0 i.e it is a wall (value of -1) then continue to next neighbour.
+        if (stepCost < 0) continue;
 
-            // get the movement cost of that neighbour cell.
-            const double stepCost = getCost(cellType);
+        // skip cells where the agent would overlap a wall (always fits for single cell agents, walls are already skipped)
+        if (m_agentSize > 1 && m_model.clearance(nr, nc) < m_agentSize) continue;
 
-            // if the movement cost is < 0 i.e it is a wall (value of -1) then continue to next neighbour.
-            if (stepCost < 0) continue;
+        // now since neighbour is not a wall we keep going with the calculation.
+        // calculate cost from start to current node neighbour.
+        const double newCost = current.g + stepCost;
 
-            // now since neighbour is not a wall we keep going with the calculation.
-            // calculate cost from start to current node neighbour.
-            const double newCost = current.g + stepCost;
+        // if this new cost is better than previous best path, we must update m_costGrid which holds the current best known cost to each node.
+        if (newCost < m_costGrid[nr][nc]) {
+            // records the previous node that lead to this current node, to be used to reconstruct the path.
+            m_previous[nr][nc] = {current.row, current.col};
 
-            // if this new cost is better than previous best path, we must update m_costGrid which holds the current best known cost to each node.
-            if (newCost < m_costGrid[nr][nc]) {
-                // records the previous node that lead to this current node, to be used to reconstruct the path.
-                m_previous[nr][nc] = {current.row, current.col};
+            // update m_costGrid to hold the new best know cost to the current node.
+            m_costGrid[nr][nc] = newCost;
 
-                // update m_costGrid to hold the new best know cost to the current node.
-                m_costGrid[nr][nc] = newCost;
+            // estimate cost from this node to goal using heuristic (coarse block distances).
+            const double h = heuristic(nr, nc);
 
-                // estimate cost from this node to goal using heuristic (Manhattan distance).
-                const double h = heuristic(nr, nc);
+            // add this new node to priority queue {row, col, g, f = g + h}.
+            // static_cast converts at compile time for related types like int -> double or in this case int -> uint8_t.
+            m_queue.push({static_cast<uint8_t>(nr), static_cast<uint8_t>(nc), newCost, newCost + h});
 
-                // add this new node to priority queue {row, col, g, f = g + h}.
-                // static_cast converts at compile time for related types like int -> double or in this case int -> uint8_t.
-                m_queue.push({static_cast<uint8_t>(nr), static_cast<uint8_t>(nc), newCost, newCost + h});
-            }
+            // tell the listener (if any) about the newly discovered node
+            onDiscover(static_cast<uint8_t>(nr), static_cast<uint8_t>(nc), newCost);
         }
     }
 
-    // if no path found
-    result.totalCost = -1; // Indicate no path with cost -1
-    return result;
+    return StepStatus::Expanded;
 }
 
 void Pathfinder::initialize() {
@@ -132,24 +230,21 @@ void Pathfinder::initialize() {
 
     // fills m_previous grid with {101, 101} values (see above for explanation how this is done).
     m_previous.assign(rows, std::vector<std::pair<uint8_t, uint8_t>>(cols, {101, 101}));
+
+    // empty the priority queue (a previous run can stop at the goal with nodes still queued) and forget the old result
+    m_queue = {};
+    m_result = {};
 }
 
-double Pathfinder::getCost(GridModel::CellType type) const {
-    // simply return the cost associated with each celltype
-    switch (type) {
-    case GridModel::Wall:    return -1.0;  // Impassable
-    case GridModel::Rough:   return 2.0;   // High cost
-    case GridModel::Boost:   return 0.5;   // Low cost
-    default:                 return 1.0;   // Normal/Start/Goal
-    }
+double Pathfinder::getCost(GridModel::CellType type) {
+    // Wall -1 (impassable), Rough 2.0, Boost 0.5, Normal/Start/Goal 1.0
+    return CostProfile::standard().cost(type);
 }
 
 double Pathfinder::heuristic(uint8_t row, uint8_t col) const {
-    // save the position of the goal
-    const auto goal = m_model.goalPosition();
-
-    // Manhattan distance multiplied by minimum possible cost per step (0.5 for boost)
-    return (std::abs(row - goal.first) + std::abs(col - goal.second)) * 0.5;
+    // both are lower bounds (and consistent), so the larger one is too: the block graph knows about walls, the boost
+    // distances about where the cheap cells actually are
+    return std::max(m_abstraction.estimate(row, col), m_boostHeuristic.estimate(row, col));
 }
 
 std::vector<std::pair<uint8_t, uint8_t>> Pathfinder::reconstructPath(const std::pair<uint8_t, uint8_t>& goal) const {
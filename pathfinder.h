@@ -2,10 +2,17 @@
 #define PATHFINDER_H
 
 #include "gridmodel.h"
+#include "costprofile.h"
+#include "abstractionheuristic.h"
+#include "boostheuristic.h"
+#include "generator.h"
+#include "regionpruning.h"
 #include <vector>
 #include <queue>
 #include <cmath>
 
+class GoalBounding;
+
 class Pathfinder {
 public:
     // this is what will be returned for the optimal path.
@@ -22,6 +29,49 @@ public:
     // execute pathfinding algo and return list of co-ordinates representing the path [{a,b}, {b,c}, {c,d}].
     // if path doesnt exist then return empty vector
     PathResult findPath();
+
+    // returns the movement cost for a given terrain type (cost of moving INTO a cell of that type, -1 for walls).
+    // these are the costs of CostProfile::standard(), the profile every search uses unless setCostProfile() says otherwise.
+    static double getCost(GridModel::CellType type);
+
+    // a single step of the search, used to visualize the search while it runs.
+    // Expanded   = cell was taken off the priority queue and its neighbours were explored.
+    // Discovered = cell was added to the priority queue (or got a cheaper cost).
+    // Finished   = search ended, lastResult() now holds the path (row/col is the goal, or {101, 101} if no path).
+    struct SearchEvent {
+        enum Type { Expanded, Discovered, Finished };
+        Type type;
+        uint8_t row;
+        uint8_t col;
+        double g; // cost from the start to this cell at the time of the event
+    };
+
+    // coroutine variant of findPath() that runs the exact same A* loop but pauses after every event.
+    // nothing is computed until the caller pulls the first event, so callers can spread the search over many frames.
+    // the Pathfinder must outlive the returned Generator, and the result is available from lastResult() once Finished is yielded.
+    Generator<SearchEvent> searchEvents();
+
+    // result of the most recent findPath() / searchEvents() run
+    const PathResult& lastResult() const noexcept { return m_result; }
+
+    // optional goal bounding boxes used to skip moves that cant lead to the goal (nullptr to switch off).
+    // the boxes are not owned and are ignored automatically if they were built for a different terrain version.
+    void setGoalBounding(const GoalBounding* goalBounding) noexcept { m_goalBounding = goalBounding; }
+
+    // optional dead-end and swamp pruning used to skip cells that cant be on the path (nullptr to switch off).
+    // not owned, and ignored automatically while it doesnt match the current terrain.
+    void setRegionPruning(const RegionPruning* regionPruning) noexcept { m_regionPruning = regionPruning; }
+
+    // size of the agent in cells (it covers size x size cells, its position is the top left one). default 1.
+    // a cell is only entered if GridModel::clearance() says the agent fits there, which is a single lookup per neighbour.
+    // goal bounding and region pruning are worked out for single cell agents, so they are skipped for bigger ones.
+    void setAgentSize(uint8_t size) noexcept { m_agentSize = std::max<uint8_t>(size, 1); }
+    uint8_t agentSize() const noexcept { return m_agentSize; }
+
+    // terrain costs of the agent searching (default CostProfile::standard()). the heuristics are scaled by the profile's
+    // cheapest terrain, and goal bounding / region pruning are only used if they were built for the same costs.
+    void setCostProfile(const CostProfile& profile) { m_profile = profile; }
+    const CostProfile& costProfile() const noexcept { return m_profile; }
 private:
     struct Node {
         // grid co-ordinates
@@ -50,9 +100,40 @@ private:
          */
     };
 
+    // what happened during one call of step()
+    // Expanded    = a node was expanded.
+    // Skipped     = a stale queue entry for an already visited node was thrown away.
+    // GoalReached = goal was expanded, m_result holds the path.
+    // Exhausted   = queue ran empty, there is no path (m_result.totalCost is -1).
+    enum class StepStatus { Expanded, Skipped, GoalReached, Exhausted };
+
     // save reference of GridModel from constructor to be used in methods of PathFinder class
     const GridModel& m_model;
 
+    // result of the last search, filled in by step() once the search ends
+    PathResult m_result {};
+
+    // goal bounding set by setGoalBounding(), and the one actually used by the current search (nullptr if out of date)
+    const GoalBounding* m_goalBounding = nullptr;
+    const GoalBounding* m_activeGoalBounding = nullptr;
+
+    // coarse distances to the goal used by heuristic(), prepared at the start of every search
+    AbstractionHeuristic m_abstraction;
+
+    // relaxed distances that only use the boost cost on actual boost cells, also prepared for every search
+    BoostHeuristic m_boostHeuristic;
+
+    // region pruning set by setRegionPruning(), the one used by the current search, and its start/goal lookup
+    const RegionPruning* m_regionPruning = nullptr;
+    const RegionPruning* m_activeRegionPruning = nullptr;
+    RegionPruning::Query m_regionQuery {};
+
+    // see setAgentSize()
+    uint8_t m_agentSize = 1;
+
+    // see setCostProfile()
+    CostProfile m_profile;
+
     // tracks the lowest known cost to reach each cell from the start.
     // 2D vector matching grid dimensions.
     // all cells start at infinity (unreachable).
@@ -77,10 +158,18 @@ private:
     // resets all algorithm state before a new pathfinding run.
     void initialize();
 
-    // returns the movement cost for a given terrain type.
-    double getCost(GridModel::CellType type) const;
+    // resets the state and pushes the start node. returns false if start or goal are not set.
+    bool beginSearch();
+
+    // pops one node from the priority queue and expands it (the body of the A* loop).
+    // both findPath() and searchEvents() drive the search through this function so the algorithm only exists once.
+    // (onDiscover) is called with (row, col, g) for every improved neighbour. findPath() passes an empty lambda that
+    // the compiler removes completely, so the plain search pays nothing for the visualization support.
+    template <typename OnDiscover>
+    StepStatus step(Node& current, OnDiscover&& onDiscover);
 
-    // estimates the remaining cost from a cell to the goal. (Manhattan distance)
+    // estimates the remaining cost from a cell to the goal. (coarse block distances and boost-aware distances, see
+    // AbstractionHeuristic and BoostHeuristic)
     double heuristic(uint8_t row, uint8_t col) const;
 
     // backtraces from the goal to the start using parent pointers.
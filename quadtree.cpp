@@ -0,0 +1,286 @@
+#include "quadtree.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+constexpr double kOutside = -2.0;
+}
+
+Quadtree::Quadtree(const GridModel& model, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    m_leafOf.assign(m_graph.size(), -1);
+
+    // smallest power of two covering both dimensions
+    int size = 1;
+    while (size < std::max(m_graph.rowCount(), m_graph.colCount())) size *= 2;
+    m_root = addNode(0, 0, size, -1);
+    build(m_root);
+    assignLeaves(m_root);
+}
+
+double Quadtree::cellCost(int row, int col) const
+{
+    if (row >= m_graph.rowCount() || col >= m_graph.colCount()) return kOutside;
+    return m_graph.cost(m_graph.index(row, col));
+}
+
+int Quadtree::addNode(int row, int col, int size, int parent)
+{
+    const Node node {static_cast<uint8_t>(row), static_cast<uint8_t>(col), static_cast<uint16_t>(size), 0.0, parent, {-1, -1, -1, -1}};
+    if (!m_freeNodes.empty()) {
+        const int id = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        m_nodes[id] = node;
+        return id;
+    }
+    m_nodes.push_back(node);
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void Quadtree::build(int id)
+{
+    const int row = m_nodes[id].row;
+    const int col = m_nodes[id].col;
+    const int size = m_nodes[id].size;
+
+    // a leaf if the whole block has one terrain
+    const double cost = cellCost(row, col);
+    bool uniform = true;
+    for (int r = row; r < row + size && uniform; ++r) {
+        for (int c = col; c < col + size && uniform; ++c) uniform = cellCost(r, c) == cost;
+    }
+    if (uniform) {
+        m_nodes[id].cost = cost;
+        return;
+    }
+
+    const int half = size / 2;
+    for (int quarter = 0; quarter < 4; ++quarter) {
+        const int child = addNode(row + (quarter / 2) * half, col + (quarter % 2) * half, half, id);
+        m_nodes[id].children[quarter] = child;
+        build(child);
+    }
+}
+
+void Quadtree::split(int id)
+{
+    const int half = m_nodes[id].size / 2;
+    for (int quarter = 0; quarter < 4; ++quarter) {
+        const int child = addNode(m_nodes[id].row + (quarter / 2) * half, m_nodes[id].col + (quarter % 2) * half, half, id);
+        m_nodes[child].cost = m_nodes[id].cost;
+        m_nodes[id].children[quarter] = child;
+    }
+}
+
+void Quadtree::assignLeaves(int id)
+{
+    const Node& node = m_nodes[id];
+    if (!node.isLeaf()) {
+        for (int child : node.children) assignLeaves(child);
+        return;
+    }
+    const int bottom = std::min<int>(node.row + node.size, m_graph.rowCount());
+    const int right = std::min<int>(node.col + node.size, m_graph.colCount());
+    for (int r = node.row; r < bottom; ++r) {
+        for (int c = node.col; c < right; ++c) m_leafOf[r * m_graph.colCount() + c] = id;
+    }
+}
+
+void Quadtree::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    m_graph.refreshCell(model, row, col);
+    const double cost = cellCost(row, col);
+    int id = m_leafOf[m_graph.index(row, col)];
+    if (m_nodes[id].cost == cost) return;
+    const int changed = id;
+
+    // split down to a single cell leaf and give it the new terrain
+    while (m_nodes[id].size > 1) {
+        split(id);
+        const int half = m_nodes[id].size / 2;
+        const int quarter = (row >= m_nodes[id].row + half ? 2 : 0) + (col >= m_nodes[id].col + half ? 1 : 0);
+        id = m_nodes[id].children[quarter];
+    }
+    m_nodes[id].cost = cost;
+
+    // merge back up while all 4 quarters are leaves of the same terrain
+    int top = changed;
+    for (int parent = m_nodes[id].parent; parent >= 0; parent = m_nodes[parent].parent) {
+        const Node& node = m_nodes[parent];
+        bool mergeable = true;
+        for (int child : node.children) {
+            mergeable = mergeable && m_nodes[child].isLeaf() && m_nodes[child].cost == cost;
+        }
+        if (!mergeable) break;
+        for (int& child : m_nodes[parent].children) {
+            m_nodes[child].size = 0;
+            m_freeNodes.push_back(child);
+            child = -1;
+        }
+        m_nodes[parent].cost = cost;
+        if (m_nodes[parent].size > m_nodes[top].size) top = parent;
+    }
+    assignLeaves(top);
+}
+
+template <typename Visit>
+void Quadtree::forEachAdjacentLeaf(int leaf, Visit&& visit) const
+{
+    const Node& node = m_nodes[leaf];
+    const int rows = m_graph.rowCount();
+    const int cols = m_graph.colCount();
+    const int bottom = std::min<int>(node.row + node.size, rows);
+    const int right = std::min<int>(node.col + node.size, cols);
+
+    // walk along each side just outside the leaf, jumping over a neighbouring leaf at a time
+    auto visitAt = [&](int r, int c) {
+        const int other = m_leafOf[r * cols + c];
+        if (m_nodes[other].cost >= 0) visit(other);
+        return other;
+    };
+    for (int c = node.col; c < right;) {
+        if (node.row == 0) break;
+        const Node& other = m_nodes[visitAt(node.row - 1, c)];
+        c = other.col + other.size;
+    }
+    for (int c = node.col; c < right;) {
+        if (bottom >= rows) break;
+        const Node& other = m_nodes[visitAt(bottom, c)];
+        c = other.col + other.size;
+    }
+    for (int r = node.row; r < bottom;) {
+        if (node.col == 0) break;
+        const Node& other = m_nodes[visitAt(r, node.col - 1)];
+        r = other.row + other.size;
+    }
+    for (int r = node.row; r < bottom;) {
+        if (right >= cols) break;
+        const Node& other = m_nodes[visitAt(r, right)];
+        r = other.row + other.size;
+    }
+}
+
+Pathfinder::PathResult Quadtree::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal)
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    m_lastLeafExpansions = 0;
+    m_lastCellExpansions = 0;
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return result;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (!m_graph.passable(s) || !m_graph.passable(t)) return result;
+
+    using QueueEntry = std::pair<double, int>;
+    const double minCost = m_graph.minCost();
+    const int startLeaf = m_leafOf[s];
+    const int goalLeaf = m_leafOf[t];
+
+    // coarse search: one node per leaf, placed at the start/goal cell for their leaves and at the centre otherwise
+    auto point = [&](int leaf) -> std::pair<int, int> {
+        if (leaf == startLeaf) return start;
+        if (leaf == goalLeaf) return goal;
+        const Node& node = m_nodes[leaf];
+        return {node.row + node.size / 2, node.col + node.size / 2};
+    };
+    auto distance = [](std::pair<int, int> a, std::pair<int, int> b) {
+        return std::abs(a.first - b.first) + std::abs(a.second - b.second);
+    };
+
+    const size_t nodeCount = m_nodes.size();
+    std::vector<double> leafG(nodeCount, std::numeric_limits<double>::infinity());
+    std::vector<int> leafParent(nodeCount, -1);
+    std::vector<char> leafClosed(nodeCount, 0);
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> leafQueue;
+    leafG[startLeaf] = 0.0;
+    leafQueue.push({distance(start, goal) * minCost, startLeaf});
+    bool found = false;
+    while (!leafQueue.empty()) {
+        const int current = leafQueue.top().second;
+        leafQueue.pop();
+        if (leafClosed[current]) continue;
+        leafClosed[current] = 1;
+        ++m_lastLeafExpansions;
+        if (current == goalLeaf) {
+            found = true;
+            break;
+        }
+        const auto from = point(current);
+        forEachAdjacentLeaf(current, [&](int next) {
+            // travel from point to point, half of the way on each leaf's terrain
+            const auto to = point(next);
+            const double newCost = leafG[current] + distance(from, to) * (m_nodes[current].cost + m_nodes[next].cost) / 2.0;
+            if (newCost < leafG[next]) {
+                leafG[next] = newCost;
+                leafParent[next] = current;
+                leafQueue.push({newCost + distance(to, goal) * minCost, next});
+            }
+        });
+    }
+    if (!found) return result;
+
+    // refinement may use the leaves of the coarse route and their neighbours
+    std::vector<char> allowed(m_graph.size(), 0);
+    auto allowLeaf = [&](int leaf) {
+        const Node& node = m_nodes[leaf];
+        for (int r = node.row; r < node.row + node.size; ++r) {
+            for (int c = node.col; c < node.col + node.size; ++c) allowed[r * m_graph.colCount() + c] = 1;
+        }
+    };
+    for (int leaf = goalLeaf; leaf != -1; leaf = leafParent[leaf]) {
+        allowLeaf(leaf);
+        forEachAdjacentLeaf(leaf, allowLeaf);
+    }
+
+    // fine search: plain A* over the allowed cells
+    const int n = m_graph.size();
+    std::vector<double> g(n, std::numeric_limits<double>::infinity());
+    std::vector<int> parent(n, -1);
+    std::vector<char> closed(n, 0);
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+    g[s] = 0.0;
+    queue.push({distance(start, goal) * minCost, s});
+    while (!queue.empty()) {
+        const int current = queue.top().second;
+        queue.pop();
+        if (closed[current]) continue;
+        closed[current] = 1;
+        ++m_lastCellExpansions;
+        if (current == t) {
+            for (int cell = t; cell != -1; cell = parent[cell]) result.path.push_back(m_graph.cell(cell));
+            std::reverse(result.path.begin(), result.path.end());
+            result.totalCost = g[t];
+            return result;
+        }
+        m_graph.forEachNeighbour(current, [&](int nb, int) {
+            if (!allowed[nb]) return;
+            const double newCost = g[current] + m_graph.cost(nb);
+            if (newCost < g[nb]) {
+                g[nb] = newCost;
+                parent[nb] = current;
+                queue.push({newCost + distance(m_graph.cell(nb), goal) * minCost, nb});
+            }
+        });
+    }
+    return result;
+}
+
+Quadtree::Stats Quadtree::stats() const
+{
+    Stats stats;
+    for (const Node& node : m_nodes) {
+        if (node.size == 0) continue;
+        ++stats.nodes;
+        if (!node.isLeaf()) continue;
+        ++stats.leaves;
+        stats.passableLeaves += node.cost >= 0;
+    }
+    stats.lastLeafExpansions = m_lastLeafExpansions;
+    stats.lastCellExpansions = m_lastCellExpansions;
+    return stats;
+}
@@ -0,0 +1,89 @@
+#ifndef QUADTREE_H
+#define QUADTREE_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <vector>
+
+// Adaptive quadtree over the grid.
+// The grid is covered by one square block that is split into 4 quarters for as long as a block holds more than one
+// terrain type, so every leaf is a square of a single terrain (or walls). Mostly open maps collapse into a few hundred
+// leaves instead of tens of thousands of cells.
+// findPath() searches coarse-to-fine: A* over the leaves first (each leaf is one node), then a cell level A* that may
+// only use the leaves along that route and their direct neighbours. The result is always a valid path but not
+// guaranteed to be the cheapest one, in exchange for expanding a fraction of the cells.
+// Edits split the leaf down to the edited cell and merge quarters back together once they match again (cellChanged()).
+class Quadtree {
+public:
+    // a square block of the tree. leaves have no children (children[0] == -1)
+    struct Node {
+        uint8_t row;
+        uint8_t col;
+        uint16_t size;        // side length, a power of two
+        double cost;          // terrain cost of a leaf (-1 for walls, -2 for blocks outside of the grid)
+        int parent;
+        int children[4];      // top left, top right, bottom left, bottom right
+
+        bool isLeaf() const noexcept { return children[0] < 0; }
+    };
+
+    struct Stats {
+        int nodes = 0;
+        int leaves = 0;
+        int passableLeaves = 0;      // leaves a coarse search can visit
+        int lastLeafExpansions = 0;  // leaves expanded by the coarse search of the last findPath() call
+        int lastCellExpansions = 0;  // cells expanded by the refining search of the last findPath() call
+    };
+
+    // builds the tree for the whole grid, leaves are squares of one cost under the profile (build one per profile)
+    explicit Quadtree(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // splits or merges the leaves around the edited cell
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // coarse-to-fine search, same result format as Pathfinder::findPath()
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal);
+
+    // leaf containing the cell
+    int leafOf(uint8_t row, uint8_t col) const { return m_leafOf[m_graph.index(row, col)]; }
+
+    // all nodes (entries of removed nodes have size 0 and are reused later)
+    const std::vector<Node>& nodes() const noexcept { return m_nodes; }
+
+    Stats stats() const;
+
+private:
+    // terrain of a cell used to decide if blocks can be merged (-2 outside of the grid)
+    double cellCost(int row, int col) const;
+
+    // allocates a node (reusing removed slots)
+    int addNode(int row, int col, int size, int parent);
+
+    // builds the subtree of a freshly added node from the grid
+    void build(int id);
+
+    // turns a leaf into 4 leaves of the same terrain
+    void split(int id);
+
+    // writes the leaf index of every cell inside the node
+    void assignLeaves(int id);
+
+    // calls visit(leaf) for every passable leaf touching the leaf's border (may repeat a leaf)
+    template <typename Visit>
+    void forEachAdjacentLeaf(int leaf, Visit&& visit) const;
+
+    GridGraph m_graph;
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    int m_root = -1;
+
+    // leaf index of every cell
+    std::vector<int> m_leafOf;
+
+    int m_lastLeafExpansions = 0;
+    int m_lastCellExpansions = 0;
+};
+
+#endif // QUADTREE_H
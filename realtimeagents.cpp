@@ -0,0 +1,216 @@
+#include "realtimeagents.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+RealTimeAgents::RealTimeAgents(const GridModel& model, int lookahead)
+    : m_graph(model)
+    , m_lookahead(std::max(lookahead, 1))
+{
+}
+
+void RealTimeAgents::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    const int cell = m_graph.index(row, col);
+    const double oldCost = m_graph.cost(cell);
+    m_graph.refreshCell(model, row, col);
+    const double newCost = m_graph.cost(cell);
+    if ((oldCost < 0) != (newCost < 0) || newCost < oldCost) m_learned.clear();
+
+    // an agent standing on a new wall cant go anywhere from there
+    for (size_t id = 0; id < m_agents.size(); ++id) {
+        if (!m_removed[id] && m_agents[id].position == std::make_pair(row, col) && newCost < 0) m_agents[id].stuck = true;
+    }
+}
+
+void RealTimeAgents::setLookahead(int lookahead)
+{
+    m_lookahead = std::max(lookahead, 1);
+}
+
+int RealTimeAgents::addAgent(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal)
+{
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) throw std::out_of_range("Coordinates out of grid bounds");
+
+    Agent agent;
+    agent.position = start;
+    agent.goal = goal;
+    agent.arrived = start == goal;
+    agent.stuck = !m_graph.passable(m_graph.index(start)) || !m_graph.passable(m_graph.index(goal));
+
+    // reuse the slot of a removed agent if there is one
+    if (!m_freeAgents.empty()) {
+        const int id = m_freeAgents.back();
+        m_freeAgents.pop_back();
+        m_agents[id] = agent;
+        m_removed[id] = 0;
+        return id;
+    }
+    m_agents.push_back(agent);
+    m_removed.push_back(0);
+    return static_cast<int>(m_agents.size()) - 1;
+}
+
+void RealTimeAgents::removeAgent(int id)
+{
+    if (m_removed[id]) return;
+    m_removed[id] = 1;
+    m_freeAgents.push_back(id);
+}
+
+int RealTimeAgents::advance(Agent& agent, std::vector<float>& learned) const
+{
+    const int start = m_graph.index(agent.position);
+    const int goal = m_graph.index(agent.goal);
+    const auto [goalRow, goalCol] = agent.goal;
+    auto h = [&](int cell) -> double {
+        if (learned[cell] >= 0) return learned[cell];
+        const auto [row, col] = m_graph.cell(cell);
+        return (std::abs(row - goalRow) + std::abs(col - goalCol)) * m_graph.minCost();
+    };
+
+    // lookahead: A* from the agent that stops after m_lookahead expansions (or at the goal)
+    struct Local {
+        double g;
+        int parent;
+        bool closed;
+    };
+    std::unordered_map<int, Local> local;
+    local.reserve(m_lookahead * 4);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> open;
+    std::vector<int> closed;
+    local[start] = {0.0, -1, false};
+    open.push({h(start), start});
+
+    int target = -1;
+    while (!open.empty()) {
+        const auto [f, cell] = open.top();
+        Local& node = local[cell];
+        if (node.closed || f != node.g + h(cell)) {
+            open.pop();
+            continue;
+        }
+        // the goal or the most promising cell at the edge of the searched area is where the agent heads
+        if (cell == goal || static_cast<int>(closed.size()) == m_lookahead) {
+            target = cell;
+            break;
+        }
+        open.pop();
+        node.closed = true;
+        closed.push_back(cell);
+        const double g = node.g;
+        m_graph.forEachNeighbour(cell, [&](int nb, int) {
+            const double newG = g + m_graph.cost(nb);
+            const auto it = local.find(nb);
+            if (it != local.end() && (it->second.closed || it->second.g <= newG)) return;
+            local[nb] = {newG, cell, false};
+            open.push({newG + h(nb), nb});
+        });
+    }
+
+    // learning: the searched cells are worth at least the cheapest way through them to the edge of the search plus
+    // what is known from there (a Dijkstra from the edge inwards). cells with no edge in reach cant reach the goal
+    std::vector<double> backedUp(closed.size(), std::numeric_limits<double>::infinity());
+    std::unordered_map<int, int> slotOf;
+    for (size_t i = 0; i < closed.size(); ++i) slotOf[closed[i]] = static_cast<int>(i);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> backup;
+    for (const auto& [cell, node] : local) {
+        if (!node.closed) backup.push({h(cell), cell});
+    }
+    while (!backup.empty()) {
+        const auto [value, cell] = backup.top();
+        backup.pop();
+        const auto own = slotOf.find(cell);
+        if (own != slotOf.end() && value > backedUp[own->second]) continue;
+        m_graph.forEachNeighbour(cell, [&](int nb, int) {
+            const auto it = slotOf.find(nb);
+            if (it == slotOf.end()) return;
+            // stepping from nb into cell costs cell's terrain
+            const double newValue = value + m_graph.cost(cell);
+            if (newValue < backedUp[it->second]) {
+                backedUp[it->second] = newValue;
+                backup.push({newValue, nb});
+            }
+        });
+    }
+    for (size_t i = 0; i < closed.size(); ++i) {
+        learned[closed[i]] = static_cast<float>(std::max(h(closed[i]), backedUp[i]));
+    }
+
+    if (target < 0) {
+        // the whole reachable area fit into the lookahead without meeting the goal
+        agent.stuck = true;
+        return static_cast<int>(closed.size());
+    }
+
+    // one step along the searched path towards the target
+    int next = target;
+    while (local[next].parent != start) next = local[next].parent;
+    agent.cost += m_graph.cost(next);
+    ++agent.steps;
+    agent.position = m_graph.cell(next);
+    agent.arrived = next == goal;
+    return static_cast<int>(closed.size());
+}
+
+int RealTimeAgents::tick()
+{
+    // agents heading for the same goal share a table, so they are moved one after another by the same job. tables are
+    // created up front because the map must not change while the jobs run
+    std::unordered_map<int, int> groupOf;
+    std::vector<std::vector<int>> groups;
+    std::vector<std::vector<float>*> tables;
+    for (size_t id = 0; id < m_agents.size(); ++id) {
+        const Agent& agent = m_agents[id];
+        if (m_removed[id] || agent.arrived || agent.stuck) continue;
+        const int goal = m_graph.index(agent.goal);
+        const auto [it, inserted] = groupOf.try_emplace(goal, static_cast<int>(groups.size()));
+        if (inserted) {
+            groups.emplace_back();
+            std::vector<float>& table = m_learned[goal];
+            if (table.empty()) table.assign(m_graph.size(), -1.0f);
+            tables.push_back(&table);
+        }
+        groups[it->second].push_back(static_cast<int>(id));
+    }
+
+    std::atomic<int> moved = 0;
+    std::atomic<int> expansions = 0;
+    std::atomic<int> maxExpansions = 0;
+    WorkerPool::instance().parallelFor(static_cast<int>(groups.size()), [&](int begin, int end) {
+        for (int group = begin; group < end; ++group) {
+            for (int id : groups[group]) {
+                Agent& agent = m_agents[id];
+                const int expanded = advance(agent, *tables[group]);
+                expansions += expanded;
+                int seen = maxExpansions;
+                while (expanded > seen && !maxExpansions.compare_exchange_weak(seen, expanded)) {}
+                if (!agent.stuck) ++moved;
+            }
+        }
+    });
+
+    m_lastTickExpansions = expansions;
+    m_lastTickMaxExpansions = maxExpansions;
+    return moved;
+}
+
+RealTimeAgents::Stats RealTimeAgents::stats() const
+{
+    Stats stats;
+    for (size_t id = 0; id < m_agents.size(); ++id) {
+        if (m_removed[id]) continue;
+        ++stats.agents;
+        stats.arrived += m_agents[id].arrived;
+    }
+    stats.learnedGoals = static_cast<int>(m_learned.size());
+    stats.lastTickExpansions = m_lastTickExpansions;
+    stats.lastTickMaxExpansions = m_lastTickMaxExpansions;
+    return stats;
+}
@@ -0,0 +1,73 @@
+#ifndef REALTIMEAGENTS_H
+#define REALTIMEAGENTS_H
+
+#include "gridgraph.h"
+#include "gridmodel.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Real-time agents (LSS-LRTA*): instead of planning a whole path, every tick each agent searches at most lookahead
+// cells around itself with A*, learns better heuristic values for the cells it searched and takes one step towards
+// the most promising cell at the edge of that search. The work per agent and tick is bounded by the lookahead no
+// matter how big the grid or how far the goal is, at the price of detours while the heuristic is still being learned.
+// Learned values go into one table per goal shared by all agents heading there, so later agents profit from what
+// earlier ones found out (dead ends, walls in the way). Agents with different goals are moved in parallel on the
+// WorkerPool. Agents dont block each other, use CooperativePathfinder for that.
+class RealTimeAgents {
+public:
+    static constexpr int kDefaultLookahead = 32;
+
+    struct Agent {
+        std::pair<uint8_t, uint8_t> position;
+        std::pair<uint8_t, uint8_t> goal;
+        double cost = 0.0;     // paid for all steps so far
+        int steps = 0;
+        bool arrived = false;
+        bool stuck = false;    // the goal cant be reached, the agent stopped
+    };
+
+    struct Stats {
+        int agents = 0;
+        int arrived = 0;
+        int learnedGoals = 0;          // goals with a learned heuristic table
+        int lastTickExpansions = 0;    // cells expanded by all lookahead searches of the last tick
+        int lastTickMaxExpansions = 0; // most cells expanded for one agent in the last tick (never above the lookahead)
+    };
+
+    explicit RealTimeAgents(const GridModel& model, int lookahead = kDefaultLookahead);
+
+    // copies one edited cell from the model. if the cell got cheaper the learned values may be too high now, so all
+    // tables are forgotten (values learned on a more expensive map stay valid lower bounds otherwise)
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // cells searched per agent and tick (at least 1)
+    void setLookahead(int lookahead);
+
+    // returns the id of the new agent. throws std::out_of_range for cells outside the grid
+    int addAgent(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal);
+    void removeAgent(int id);
+    const Agent& agent(int id) const { return m_agents[id]; }
+
+    // moves every agent that has not arrived (or given up) one cell. returns how many moved
+    int tick();
+
+    Stats stats() const;
+
+private:
+    // one lookahead, learning and step for an agent, returns the cells expanded
+    int advance(Agent& agent, std::vector<float>& learned) const;
+
+    GridGraph m_graph;
+    int m_lookahead;
+    std::vector<Agent> m_agents;
+    std::vector<char> m_removed;
+    std::vector<int> m_freeAgents;
+
+    // learned cost to the goal per cell (-1 where nothing was learned yet), one table per goal cell
+    std::unordered_map<int, std::vector<float>> m_learned;
+    int m_lastTickExpansions = 0;
+    int m_lastTickMaxExpansions = 0;
+};
+
+#endif // REALTIMEAGENTS_H
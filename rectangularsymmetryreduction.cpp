@@ -0,0 +1,234 @@
+#include "rectangularsymmetryreduction.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+
+RectangularSymmetryReduction::RectangularSymmetryReduction(const GridModel& model, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    m_rectOf.assign(m_graph.size(), -1);
+    decompose(0, 0, m_graph.rowCount() - 1, m_graph.colCount() - 1);
+}
+
+void RectangularSymmetryReduction::decompose(int top, int left, int bottom, int right)
+{
+    const int cols = m_graph.colCount();
+
+    // a cell can join the rectangle if it is free, unassigned and has the seed's terrain
+    auto usable = [&](int row, int col, double cost) {
+        const int cell = row * cols + col;
+        return m_graph.passable(cell) && m_rectOf[cell] == -1 && m_graph.cost(cell) == cost;
+    };
+    auto rowUsable = [&](int row, int from, int to, double cost) {
+        for (int col = from; col <= to; ++col) {
+            if (!usable(row, col, cost)) return false;
+        }
+        return true;
+    };
+    auto colUsable = [&](int col, int from, int to, double cost) {
+        for (int row = from; row <= to; ++row) {
+            if (!usable(row, col, cost)) return false;
+        }
+        return true;
+    };
+
+    for (int row = top; row <= bottom; ++row) {
+        for (int col = left; col <= right; ++col) {
+            const int seed = row * cols + col;
+            if (!m_graph.passable(seed) || m_rectOf[seed] != -1) continue;
+            const double cost = m_graph.cost(seed);
+
+            // option 1: as wide as possible, then as tall as that width allows
+            int wideRight = col;
+            while (wideRight + 1 <= right && usable(row, wideRight + 1, cost)) ++wideRight;
+            int wideBottom = row;
+            while (wideBottom + 1 <= bottom && rowUsable(wideBottom + 1, col, wideRight, cost)) ++wideBottom;
+
+            // option 2: as tall as possible, then as wide as that height allows
+            int tallBottom = row;
+            while (tallBottom + 1 <= bottom && usable(tallBottom + 1, col, cost)) ++tallBottom;
+            int tallRight = col;
+            while (tallRight + 1 <= right && colUsable(tallRight + 1, row, tallBottom, cost)) ++tallRight;
+
+            // keep whichever covers more cells
+            Rect rect;
+            if ((wideRight - col + 1) * (wideBottom - row + 1) >= (tallRight - col + 1) * (tallBottom - row + 1)) {
+                rect = {static_cast<uint8_t>(row), static_cast<uint8_t>(col), static_cast<uint8_t>(wideBottom), static_cast<uint8_t>(wideRight)};
+            } else {
+                rect = {static_cast<uint8_t>(row), static_cast<uint8_t>(col), static_cast<uint8_t>(tallBottom), static_cast<uint8_t>(tallRight)};
+            }
+
+            // reuse the slot of a removed rectangle if there is one
+            int id;
+            if (!m_freeRects.empty()) {
+                id = m_freeRects.back();
+                m_freeRects.pop_back();
+                m_rects[id] = rect;
+            } else {
+                id = static_cast<int>(m_rects.size());
+                m_rects.push_back(rect);
+            }
+            for (int r = rect.top; r <= rect.bottom; ++r) {
+                for (int c = rect.left; c <= rect.right; ++c) m_rectOf[r * cols + c] = id;
+            }
+        }
+    }
+}
+
+void RectangularSymmetryReduction::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    const int cell = m_graph.index(row, col);
+    m_graph.refreshCell(model, row, col);
+
+    // dissolve the rectangle that held the cell, plus neighbouring rectangles of the cell's new terrain so the cell
+    // can merge into them, then cut that area up again. everything else stays as it is.
+    std::vector<int> dissolve;
+    if (m_rectOf[cell] >= 0) dissolve.push_back(m_rectOf[cell]);
+    m_graph.forEachNeighbour(cell, [&](int nb, int) {
+        if (m_rectOf[nb] >= 0 && m_graph.cost(nb) == m_graph.cost(cell)) dissolve.push_back(m_rectOf[nb]);
+    });
+    std::sort(dissolve.begin(), dissolve.end());
+    dissolve.erase(std::unique(dissolve.begin(), dissolve.end()), dissolve.end());
+
+    int top = row, left = col, bottom = row, right = col;
+    for (int id : dissolve) {
+        Rect& rect = m_rects[id];
+        top = std::min<int>(top, rect.top);
+        left = std::min<int>(left, rect.left);
+        bottom = std::max<int>(bottom, rect.bottom);
+        right = std::max<int>(right, rect.right);
+        for (int r = rect.top; r <= rect.bottom; ++r) {
+            for (int c = rect.left; c <= rect.right; ++c) m_rectOf[m_graph.index(r, c)] = -1;
+        }
+        // mark as removed (top > bottom) and free the slot
+        rect = {1, 0, 0, 0};
+        m_freeRects.push_back(id);
+    }
+    m_rectOf[cell] = -1;
+
+    decompose(top, left, bottom, right);
+}
+
+bool RectangularSymmetryReduction::onPerimeter(int cell) const
+{
+    const Rect& rect = m_rects[m_rectOf[cell]];
+    const auto [row, col] = m_graph.cell(cell);
+    return row == rect.top || row == rect.bottom || col == rect.left || col == rect.right;
+}
+
+Pathfinder::PathResult RectangularSymmetryReduction::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal)
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    m_lastExpansions = 0;
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return result;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (!m_graph.passable(s) || !m_graph.passable(t)) return result;
+
+    const int n = m_graph.size();
+    const double minCost = m_graph.minCost();
+    auto manhattan = [this](int a, int b) {
+        const auto [ar, ac] = m_graph.cell(a);
+        const auto [br, bc] = m_graph.cell(b);
+        return std::abs(ar - br) + std::abs(ac - bc);
+    };
+
+    std::vector<double> g(n, std::numeric_limits<double>::infinity());
+    std::vector<int> parent(n, -1);
+    std::vector<char> closed(n, 0);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+    g[s] = 0.0;
+    queue.push({manhattan(s, t) * minCost, s});
+
+    auto relax = [&](int from, int to, double weight) {
+        const double newCost = g[from] + weight;
+        if (newCost < g[to]) {
+            g[to] = newCost;
+            parent[to] = from;
+            queue.push({newCost + manhattan(to, t) * minCost, to});
+        }
+    };
+
+    while (!queue.empty()) {
+        const int current = queue.top().second;
+        queue.pop();
+        if (closed[current]) continue;
+        closed[current] = 1;
+        ++m_lastExpansions;
+
+        if (current == t) {
+            // the path holds jumps across rectangles, fill in the cells (rows first, then columns, which always stays
+            // inside the rectangle both ends share)
+            std::vector<int> nodes;
+            for (int cell = t; cell != -1; cell = parent[cell]) nodes.push_back(cell);
+            std::reverse(nodes.begin(), nodes.end());
+            result.path.push_back(m_graph.cell(s));
+            for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+                auto [row, col] = m_graph.cell(nodes[i]);
+                const auto [toRow, toCol] = m_graph.cell(nodes[i + 1]);
+                while (row != toRow) {
+                    row += toRow > row ? 1 : -1;
+                    result.path.push_back({row, col});
+                }
+                while (col != toCol) {
+                    col += toCol > col ? 1 : -1;
+                    result.path.push_back({row, col});
+                }
+            }
+            result.totalCost = g[t];
+            return result;
+        }
+
+        const int id = m_rectOf[current];
+        const Rect& rect = m_rects[id];
+        const double cost = m_graph.cost(current);
+        const auto [row, col] = m_graph.cell(current);
+
+        // inside the goal's rectangle the goal is reachable directly
+        if (m_rectOf[t] == id) relax(current, t, manhattan(current, t) * cost);
+
+        if (!onPerimeter(current)) {
+            // only the start can be an interior cell: connect it to every border cell of its rectangle
+            for (int r = rect.top; r <= rect.bottom; ++r) {
+                for (int c = rect.left; c <= rect.right; ++c) {
+                    const int cell = m_graph.index(r, c);
+                    if (onPerimeter(cell)) relax(current, cell, manhattan(current, cell) * cost);
+                }
+            }
+            continue;
+        }
+
+        // walk along the border or step out into another rectangle (never into this rectangle's interior)
+        m_graph.forEachNeighbour(current, [&](int nb, int) {
+            if (m_rectOf[nb] == id && !onPerimeter(nb)) return;
+            relax(current, nb, m_graph.cost(nb));
+        });
+
+        // jump straight across to the opposite border
+        if (row == rect.top && rect.bottom > rect.top + 1) relax(current, m_graph.index(rect.bottom, col), (rect.bottom - rect.top) * cost);
+        if (row == rect.bottom && rect.bottom > rect.top + 1) relax(current, m_graph.index(rect.top, col), (rect.bottom - rect.top) * cost);
+        if (col == rect.left && rect.right > rect.left + 1) relax(current, m_graph.index(row, rect.right), (rect.right - rect.left) * cost);
+        if (col == rect.right && rect.right > rect.left + 1) relax(current, m_graph.index(row, rect.left), (rect.right - rect.left) * cost);
+    }
+    return result;
+}
+
+RectangularSymmetryReduction::Stats RectangularSymmetryReduction::stats() const
+{
+    Stats stats;
+    for (const Rect& rect : m_rects) stats.rectangles += rect.top <= rect.bottom;
+    for (int cell = 0; cell < m_graph.size(); ++cell) {
+        if (m_rectOf[cell] < 0) continue;
+        if (onPerimeter(cell)) {
+            ++stats.perimeterCells;
+        } else {
+            ++stats.interiorCells;
+        }
+    }
+    stats.lastExpansions = m_lastExpansions;
+    return stats;
+}
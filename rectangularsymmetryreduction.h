@@ -0,0 +1,69 @@
+#ifndef RECTANGULARSYMMETRYREDUCTION_H
+#define RECTANGULARSYMMETRYREDUCTION_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <vector>
+
+// Rectangular Symmetry Reduction (RSR).
+// Open areas have huge numbers of equally cheap paths through them, and plain A* expands most of the area just to find
+// out they are all the same. RSR cuts every area of one terrain type into rectangles, and inside a rectangle of one
+// terrain the cost between two border cells is simply the Manhattan distance times the terrain cost. So a search only
+// has to look at the border (perimeter) of each rectangle: walk along the border, step out into a neighbouring
+// rectangle, or jump straight across to the opposite side. The interior cells are never expanded.
+// When a cell is edited only the rectangle that contained it is cut up again (cellChanged()).
+class RectangularSymmetryReduction {
+public:
+    // inclusive bounds of a rectangle of one terrain type
+    struct Rect {
+        uint8_t top;
+        uint8_t left;
+        uint8_t bottom;
+        uint8_t right;
+    };
+
+    struct Stats {
+        int rectangles = 0;
+        int perimeterCells = 0;   // cells a search may expand
+        int interiorCells = 0;    // cells a search never expands
+        int lastExpansions = 0;   // nodes expanded by the last findPath() call
+    };
+
+    // cuts the whole grid into rectangles of one cost under the profile (build one per profile)
+    explicit RectangularSymmetryReduction(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // re-decomposes only the area of the rectangle containing the edited cell
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // A* that only expands rectangle perimeters, same result format as Pathfinder::findPath()
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal);
+
+    // rectangle a cell belongs to, or -1 for walls
+    int rectOf(uint8_t row, uint8_t col) const { return m_rectOf[m_graph.index(row, col)]; }
+
+    // all rectangles (entries of removed rectangles have top > bottom and are reused later)
+    const std::vector<Rect>& rects() const noexcept { return m_rects; }
+
+    Stats stats() const;
+
+private:
+    // greedily covers the unassigned passable cells inside the given area with the largest rectangles it can find
+    void decompose(int top, int left, int bottom, int right);
+
+    // true if a cell lies on the border of its rectangle
+    bool onPerimeter(int cell) const;
+
+    GridGraph m_graph;
+
+    // rectangle index of every cell (-1 for walls)
+    std::vector<int> m_rectOf;
+    std::vector<Rect> m_rects;
+
+    // indices of removed rectangles that can be reused
+    std::vector<int> m_freeRects;
+
+    int m_lastExpansions = 0;
+};
+
+#endif // RECTANGULARSYMMETRYREDUCTION_H
@@ -0,0 +1,305 @@
+#include "regionpruning.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+constexpr uint32_t kUnvisited = std::numeric_limits<uint32_t>::max();
+
+// swamps are grown from seeds on a lattice with this spacing
+constexpr int kSeedSpacing = 4;
+// largest swamp grown from one seed, and how many rejected cells end the growth
+constexpr int kMaxSwampCells = 32;
+constexpr int kMaxFailures = 4;
+// validation searches give up (and reject the swamp) after settling this many cells, so only swamps with a cheap
+// local detour are accepted and checking stays fast
+constexpr int kValidationSettleLimit = 256;
+}
+
+RegionPruning::RegionPruning(const GridModel& model, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    m_swampOf.assign(m_graph.size(), -1);
+    computeDeadEnds();
+    growSwamps(0, 0, m_graph.rowCount() - 1, m_graph.colCount() - 1);
+}
+
+bool RegionPruning::isUpToDate(const GridModel& model) const noexcept
+{
+    return m_graph.version() == model.version() && m_graph.rowCount() == model.rowCount() && m_graph.colCount() == model.colCount();
+}
+
+void RegionPruning::computeDeadEnds()
+{
+    const int n = m_graph.size();
+    m_order.assign(n, kUnvisited);
+    m_subtreeEnd.assign(n, 0);
+    m_deadEndRoot.assign(n, -1);
+    std::vector<uint32_t> low(n, 0);
+    std::vector<int> parent(n, -1);
+    std::vector<char> isRegionRoot(n, 0);
+    std::vector<int> byOrder;
+    byOrder.reserve(n);
+    uint32_t counter = 0;
+
+    // iterative depth first search (a recursive one could overflow the stack on a 255x255 maze).
+    // low[v] = smallest order reachable from v's subtree using one back edge. if a child's subtree cant reach above
+    // its parent, the parent is the only way in and out of that subtree: a dead end.
+    std::vector<std::pair<int, int>> stack; // {cell, next direction to try}
+    std::vector<int> rootChildren;
+    for (int root = 0; root < n; ++root) {
+        if (!m_graph.passable(root) || m_order[root] != kUnvisited) continue;
+        rootChildren.clear();
+        m_order[root] = low[root] = counter++;
+        byOrder.push_back(root);
+        stack.push_back({root, 0});
+        while (!stack.empty()) {
+            auto& [v, direction] = stack.back();
+            if (direction < 4) {
+                const int nb = m_graph.neighbour(v, direction++);
+                if (nb < 0) continue;
+                if (m_order[nb] == kUnvisited) {
+                    parent[nb] = v;
+                    m_order[nb] = low[nb] = counter++;
+                    byOrder.push_back(nb);
+                    stack.push_back({nb, 0});
+                } else if (nb != parent[v]) {
+                    low[v] = std::min(low[v], m_order[nb]);
+                }
+            } else {
+                const int finished = v;
+                stack.pop_back();
+                m_subtreeEnd[finished] = counter - 1;
+                const int p = parent[finished];
+                if (p >= 0) {
+                    low[p] = std::min(low[p], low[finished]);
+                    if (low[finished] >= m_order[p]) isRegionRoot[finished] = 1;
+                    if (p == root) rootChildren.push_back(finished);
+                }
+            }
+        }
+        // the search root only cuts off its subtrees if it has more than one
+        if (rootChildren.size() < 2) {
+            for (int child : rootChildren) isRegionRoot[child] = 0;
+        }
+    }
+
+    // smallest dead end containing each cell: its own subtree if it is a region root, otherwise its parent's
+    for (int cell : byOrder) {
+        m_deadEndRoot[cell] = isRegionRoot[cell] ? cell : (parent[cell] >= 0 ? m_deadEndRoot[parent[cell]] : -1);
+    }
+}
+
+bool RegionPruning::validSwamp(const std::vector<int>& candidate, int& top, int& left, int& bottom, int& right)
+{
+    const int n = m_graph.size();
+    std::vector<char> inCandidate(n, 0);
+    for (int cell : candidate) inCandidate[cell] = 1;
+
+    // border cells: passable neighbours of the candidate outside of it
+    std::vector<int> border;
+    for (int cell : candidate) {
+        m_graph.forEachNeighbour(cell, [&](int nb, int) {
+            if (!inCandidate[nb]) border.push_back(nb);
+        });
+    }
+    std::sort(border.begin(), border.end());
+    border.erase(std::unique(border.begin(), border.end()), border.end());
+
+    // from every border cell: cheapest costs to the other border cells with everything present, and with the
+    // candidate and all existing swamps removed. any subset of swamps can then be skipped at the same time.
+    std::atomic<bool> valid {true};
+    std::vector<int> touchedBounds(border.size() * 4);
+    WorkerPool::instance().parallelFor(static_cast<int>(border.size()), [&](int begin, int end) {
+        std::vector<double> dist(n, std::numeric_limits<double>::infinity());
+        std::vector<int> touched;
+        std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+
+        // bounded Dijkstra, returns false if the limit was reached before every border cell was settled
+        auto search = [&](int from, bool cut, std::vector<double>& result, int* bounds) {
+            dist[from] = 0.0;
+            touched.push_back(from);
+            queue.push({0.0, from});
+            int settled = 0;
+            size_t bordersSettled = 0;
+            while (!queue.empty() && bordersSettled < border.size()) {
+                const auto [d, v] = queue.top();
+                queue.pop();
+                if (d > dist[v]) continue;
+                if (++settled > kValidationSettleLimit) break;
+                if (std::binary_search(border.begin(), border.end(), v)) ++bordersSettled;
+                m_graph.forEachNeighbour(v, [&](int nb, int) {
+                    if (cut && (inCandidate[nb] || m_swampOf[nb] >= 0)) return;
+                    const double newDist = d + m_graph.cost(nb);
+                    if (newDist < dist[nb]) {
+                        if (dist[nb] == std::numeric_limits<double>::infinity()) touched.push_back(nb);
+                        dist[nb] = newDist;
+                        queue.push({newDist, nb});
+                    }
+                });
+            }
+            for (size_t i = 0; i < border.size(); ++i) result[i] = dist[border[i]];
+            // remember the area looked at (plus one cell, a change right next to it can open a new path)
+            for (int v : touched) {
+                const auto [row, col] = m_graph.cell(v);
+                bounds[0] = std::min<int>(bounds[0], row - 1);
+                bounds[1] = std::min<int>(bounds[1], col - 1);
+                bounds[2] = std::max<int>(bounds[2], row + 1);
+                bounds[3] = std::max<int>(bounds[3], col + 1);
+                dist[v] = std::numeric_limits<double>::infinity();
+            }
+            touched.clear();
+            queue = {};
+            return bordersSettled == border.size();
+        };
+
+        std::vector<double> full(border.size()), cut(border.size());
+        for (int i = begin; i < end && valid; ++i) {
+            int* bounds = &touchedBounds[i * 4];
+            bounds[0] = bounds[1] = std::numeric_limits<int>::max();
+            bounds[2] = bounds[3] = std::numeric_limits<int>::min();
+            if (!search(border[i], false, full, bounds) || !search(border[i], true, cut, bounds) || full != cut) valid = false;
+        }
+    });
+    if (!valid) return false;
+
+    top = left = std::numeric_limits<int>::max();
+    bottom = right = std::numeric_limits<int>::min();
+    for (size_t i = 0; i < border.size(); ++i) {
+        top = std::min(top, touchedBounds[i * 4]);
+        left = std::min(left, touchedBounds[i * 4 + 1]);
+        bottom = std::max(bottom, touchedBounds[i * 4 + 2]);
+        right = std::max(right, touchedBounds[i * 4 + 3]);
+    }
+    for (int cell : candidate) {
+        const auto [row, col] = m_graph.cell(cell);
+        top = std::min<int>(top, row - 1);
+        left = std::min<int>(left, col - 1);
+        bottom = std::max<int>(bottom, row + 1);
+        right = std::max<int>(right, col + 1);
+    }
+    return true;
+}
+
+void RegionPruning::growSwamp(int seed)
+{
+    // a cell can join if it is free and doesnt touch another swamp (border cells of a swamp are never swamp cells)
+    // a dissolved slot is only taken once the swamp turns out non empty
+    const int id = m_freeSwamps.empty() ? static_cast<int>(m_swamps.size()) : m_freeSwamps.back();
+    auto eligible = [&](int cell) {
+        if (!m_graph.passable(cell) || m_swampOf[cell] >= 0) return false;
+        bool touchesOther = false;
+        m_graph.forEachNeighbour(cell, [&](int nb, int) { touchesOther = touchesOther || (m_swampOf[nb] >= 0 && m_swampOf[nb] != id); });
+        return !touchesOther;
+    };
+    if (!eligible(seed)) return;
+
+    Swamp swamp {{}, 0, 0, -1, -1, true};
+    std::vector<int> candidate;
+    std::deque<int> frontier {seed};
+    std::vector<int> tried;
+    int failures = 0;
+
+    // breadth first growth, keeping every cell whose addition still passes the validation
+    while (!frontier.empty() && static_cast<int>(swamp.cells.size()) < kMaxSwampCells && failures < kMaxFailures) {
+        const int cell = frontier.front();
+        frontier.pop_front();
+        if (std::find(tried.begin(), tried.end(), cell) != tried.end() || !eligible(cell)) continue;
+        tried.push_back(cell);
+
+        candidate = swamp.cells;
+        candidate.push_back(cell);
+        int top, left, bottom, right;
+        if (!validSwamp(candidate, top, left, bottom, right)) {
+            ++failures;
+            continue;
+        }
+        swamp.cells = candidate;
+        swamp.top = top;
+        swamp.left = left;
+        swamp.bottom = bottom;
+        swamp.right = right;
+        m_graph.forEachNeighbour(cell, [&](int nb, int) { frontier.push_back(nb); });
+    }
+
+    if (swamp.cells.empty()) return;
+    for (int cell : swamp.cells) m_swampOf[cell] = id;
+    if (id < static_cast<int>(m_swamps.size())) {
+        m_freeSwamps.pop_back();
+        m_swamps[id] = std::move(swamp);
+    } else {
+        m_swamps.push_back(std::move(swamp));
+    }
+}
+
+void RegionPruning::growSwamps(int top, int left, int bottom, int right)
+{
+    top = std::max(top, 0);
+    left = std::max(left, 0);
+    bottom = std::min(bottom, m_graph.rowCount() - 1);
+    right = std::min(right, m_graph.colCount() - 1);
+
+    // seeds on a fixed lattice (not relative to the area) so regrowing after an edit picks the same seeds
+    for (int row = top; row <= bottom; ++row) {
+        if (row % kSeedSpacing != kSeedSpacing / 2) continue;
+        for (int col = left; col <= right; ++col) {
+            if (col % kSeedSpacing != kSeedSpacing / 2) continue;
+            growSwamp(m_graph.index(row, col));
+        }
+    }
+}
+
+void RegionPruning::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    m_graph.refreshCell(model, row, col);
+
+    // dead ends: one linear depth first search, cheap enough to simply redo
+    computeDeadEnds();
+
+    // swamps whose validation looked at this cell may no longer be valid: dissolve them and regrow in their area
+    int top = row - 1, left = col - 1, bottom = row + 1, right = col + 1;
+    for (size_t id = 0; id < m_swamps.size(); ++id) {
+        Swamp& swamp = m_swamps[id];
+        if (!swamp.alive || row < swamp.top || row > swamp.bottom || col < swamp.left || col > swamp.right) continue;
+        for (int cell : swamp.cells) m_swampOf[cell] = -1;
+        top = std::min(top, swamp.top);
+        left = std::min(left, swamp.left);
+        bottom = std::max(bottom, swamp.bottom);
+        right = std::max(right, swamp.right);
+        swamp.cells = {};
+        swamp.alive = false;
+        m_freeSwamps.push_back(static_cast<int>(id));
+    }
+    // a cell that turned into a wall cant stay in a swamp
+    const int cell = m_graph.index(row, col);
+    if (!m_graph.passable(cell)) m_swampOf[cell] = -1;
+
+    growSwamps(top, left, bottom, right);
+}
+
+RegionPruning::Query RegionPruning::prepare(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    Query query;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    query.startOrder = m_order[s];
+    query.goalOrder = m_order[t];
+    query.startSwamp = m_swampOf[s];
+    query.goalSwamp = m_swampOf[t];
+    return query;
+}
+
+RegionPruning::Stats RegionPruning::stats() const
+{
+    Stats stats;
+    for (int cell = 0; cell < m_graph.size(); ++cell) {
+        stats.deadEndCells += m_deadEndRoot[cell] >= 0;
+        stats.swampCells += m_swampOf[cell] >= 0;
+    }
+    for (const Swamp& swamp : m_swamps) stats.swamps += swamp.alive;
+    return stats;
+}
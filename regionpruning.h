@@ -0,0 +1,100 @@
+#ifndef REGIONPRUNING_H
+#define REGIONPRUNING_H
+
+#include "gridgraph.h"
+#include <cstdint>
+#include <vector>
+
+// Dead-end and swamp pruning.
+// Large parts of a map can never be on the cheapest path between two cells outside of them:
+//   - dead ends: areas only reachable through a single cell (a cul-de-sac or a closed room with one door). A path that
+//     goes in has to come back out through the same cell, which is never cheapest.
+//   - swamps: small areas whose surrounding cells can always reach each other just as cheaply without going through
+//     them (e.g. the middle of a room with several doors). They are found by growing areas cell by cell and checking
+//     with small Dijkstra searches that the distances between the border cells dont change when the area is removed.
+// A search can skip every dead end and swamp that contains neither the start nor the goal
+// (see Pathfinder::setRegionPruning()). Dead ends are recomputed after each edit (a single depth first search), swamps
+// are only regrown around the edited cell.
+class RegionPruning {
+public:
+    // what a single search needs, taken once per search by prepare()
+    struct Query {
+        uint32_t startOrder = 0;
+        uint32_t goalOrder = 0;
+        int startSwamp = -1;
+        int goalSwamp = -1;
+    };
+
+    struct Stats {
+        int deadEndCells = 0;  // cells inside at least one dead end
+        int swamps = 0;
+        int swampCells = 0;
+    };
+
+    // swamps depend on the terrain costs, so the regions are found for one profile (keep one RegionPruning per profile)
+    explicit RegionPruning(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // call after every edit of the model
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // true if the pruning data belongs to the model's current terrain
+    bool isUpToDate(const GridModel& model) const noexcept;
+
+    // costs the regions were found for
+    const CostProfile& profile() const noexcept { return m_graph.profile(); }
+
+    // looks up the regions the start and goal are in
+    Query prepare(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // true if a search between the query's start and goal never has to enter this cell
+    bool canSkip(const Query& query, uint8_t row, uint8_t col) const noexcept {
+        const int cell = m_graph.index(row, col);
+        const int swamp = m_swampOf[cell];
+        if (swamp >= 0 && swamp != query.startSwamp && swamp != query.goalSwamp) return true;
+        // smallest dead end containing the cell = depth first subtree [order, subtreeEnd] of its region root
+        const int root = m_deadEndRoot[cell];
+        if (root < 0) return false;
+        const uint32_t first = m_order[root];
+        const uint32_t last = m_subtreeEnd[root];
+        return (query.startOrder < first || query.startOrder > last) && (query.goalOrder < first || query.goalOrder > last);
+    }
+
+    Stats stats() const;
+
+private:
+    // a grown swamp: its cells and the area its validation searches looked at (an edit in there can invalidate it)
+    struct Swamp {
+        std::vector<int> cells;
+        int top, left, bottom, right;
+        bool alive;
+    };
+
+    // depth first search (Tarjan) finding every area cut off by a single cell
+    void computeDeadEnds();
+
+    // tries to grow a swamp from the seed cell, adds it if at least one valid cell was found
+    void growSwamp(int seed);
+
+    // true if removing "candidate" (plus all existing swamps) keeps the cost between every pair of its border cells
+    // unchanged. the area looked at by the searches is added to the bounds.
+    bool validSwamp(const std::vector<int>& candidate, int& top, int& left, int& bottom, int& right);
+
+    // seeds swamp growth on a sparse lattice inside the area
+    void growSwamps(int top, int left, int bottom, int right);
+
+    GridGraph m_graph;
+
+    // dead ends: depth first order of every cell, last order inside its subtree, and the root of the smallest dead end
+    // containing the cell (-1 if none)
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_subtreeEnd;
+    std::vector<int> m_deadEndRoot;
+
+    // swamps: swamp index of every cell (-1 if none)
+    std::vector<int> m_swampOf;
+    std::vector<Swamp> m_swamps;
+    // indices of dissolved swamps, reused before the list grows
+    std::vector<int> m_freeSwamps;
+};
+
+#endif // REGIONPRUNING_H
@@ -0,0 +1,49 @@
+#include "reservationtable.h"
+#include <algorithm>
+
+void ReservationTable::reset(int cellCount)
+{
+    m_cells.clear();
+    m_moves.clear();
+    m_lastUse.assign(cellCount, -1);
+    m_parkedFrom.assign(cellCount, kNever);
+    m_parkedCells.clear();
+    m_lastTime = -1;
+}
+
+void ReservationTable::clear()
+{
+    // the low 32 bits of a cell key are the cell
+    for (std::uint64_t cell : m_cells) m_lastUse[static_cast<std::uint32_t>(cell)] = -1;
+    for (int cell : m_parkedCells) m_parkedFrom[cell] = kNever;
+    m_cells.clear();
+    m_moves.clear();
+    m_parkedCells.clear();
+    m_lastTime = -1;
+}
+
+void ReservationTable::reserveCell(int cell, int time)
+{
+    m_cells.insert(key(cell, time));
+    m_lastUse[cell] = std::max(m_lastUse[cell], time);
+    m_lastTime = std::max(m_lastTime, time);
+}
+
+void ReservationTable::reserveMove(int from, int to, int time)
+{
+    m_moves.insert(moveKey(from, to, time));
+    m_lastTime = std::max(m_lastTime, time + 1);
+}
+
+void ReservationTable::reservePath(const std::vector<int>& cells, int startTime, bool park)
+{
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const int time = startTime + static_cast<int>(i);
+        reserveCell(cells[i], time);
+        if (i > 0 && cells[i] != cells[i - 1]) m_moves.insert(moveKey(cells[i - 1], cells[i], time - 1));
+    }
+    if (cells.empty() || !park) return;
+    const int endTime = startTime + static_cast<int>(cells.size()) - 1;
+    if (m_parkedFrom[cells.back()] == kNever) m_parkedCells.push_back(cells.back());
+    m_parkedFrom[cells.back()] = std::min(m_parkedFrom[cells.back()], endTime);
+}
@@ -0,0 +1,66 @@
+#ifndef RESERVATIONTABLE_H
+#define RESERVATIONTABLE_H
+
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+
+// Space-time reservations of agents that already planned, so later agents can plan around them.
+// Only the (cell, time) pairs that are actually taken are stored (hashed), which keeps it small on big maps with few
+// agents. Moves are reserved too, so two agents can never swap places through each other. An agent that stays on its
+// goal for good parks there: the cell is taken from that time on, without storing every later time step.
+// Cells are flat GridGraph indices (row * cols + col).
+class ReservationTable {
+public:
+    static constexpr int kNever = std::numeric_limits<int>::max();
+
+    explicit ReservationTable(int cellCount = 0) { reset(cellCount); }
+
+    // forgets every reservation
+    void reset(int cellCount);
+
+    // same as reset() for the same cell count, but only touches what was reserved (cheap for few reservations)
+    void clear();
+
+    // reserves cells[i] at time startTime + i and the moves between them. with park the agent stays on the last cell
+    void reservePath(const std::vector<int>& cells, int startTime, bool park);
+
+    // single reservations: an agent on the cell at time, or an agent moving from -> to between time and time + 1
+    // (which blocks the opposite move to -> from)
+    void reserveCell(int cell, int time);
+    void reserveMove(int from, int to, int time);
+
+    // true if no agent is on the cell at that time
+    bool cellFree(int cell, int time) const {
+        return time < m_parkedFrom[cell] && !m_cells.count(key(cell, time));
+    }
+
+    // true if no agent moves from to into from between time and time + 1 (which would be a swap)
+    bool moveFree(int from, int to, int time) const { return !m_moves.count(moveKey(to, from, time)); }
+
+    // last time any agent is on the cell without parking there (-1 if none)
+    int lastUse(int cell) const { return m_lastUse[cell]; }
+
+    // time from which an agent is parked on the cell (kNever if none)
+    int parkedFrom(int cell) const { return m_parkedFrom[cell]; }
+
+    // latest reserved time over all cells (-1 if empty). after that only parked cells are taken
+    int lastTime() const noexcept { return m_lastTime; }
+
+private:
+    static std::uint64_t key(int cell, int time) { return (static_cast<std::uint64_t>(time) << 32) | static_cast<std::uint32_t>(cell); }
+    static std::uint64_t moveKey(int from, int to, int time) {
+        // grids are at most 256x256, so both cells fit in 16 bits
+        return (static_cast<std::uint64_t>(time) << 32) | (static_cast<std::uint64_t>(from) << 16) | static_cast<std::uint64_t>(to);
+    }
+
+    std::unordered_set<std::uint64_t> m_cells;
+    std::unordered_set<std::uint64_t> m_moves;
+    std::vector<int> m_lastUse;
+    std::vector<int> m_parkedFrom;
+    std::vector<int> m_parkedCells;
+    int m_lastTime = -1;
+};
+
+#endif // RESERVATIONTABLE_H
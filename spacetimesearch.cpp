@@ -0,0 +1,106 @@
+#include "spacetimesearch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+GoalDistance::GoalDistance(const GridGraph& graph, int goal, int start)
+    : m_graph(graph)
+    , m_start(start)
+{
+    m_g.assign(graph.size(), std::numeric_limits<float>::infinity());
+    m_settled.assign(graph.size(), 0);
+    m_g[goal] = 0.0f;
+    m_open.push({0.0, goal});
+}
+
+double GoalDistance::operator()(int cell)
+{
+    while (!m_settled[cell] && !m_open.empty()) settleNext();
+    return m_settled[cell] ? m_g[cell] : std::numeric_limits<double>::infinity();
+}
+
+void GoalDistance::settleAll()
+{
+    while (!m_open.empty()) settleNext();
+}
+
+void GoalDistance::settleNext()
+{
+    const int current = m_open.top().second;
+    m_open.pop();
+    if (m_settled[current]) return;
+    m_settled[current] = 1;
+
+    // walking backwards: stepping from a neighbour into current costs current's terrain
+    const auto [startRow, startCol] = m_graph.cell(m_start);
+    m_graph.forEachNeighbour(current, [&](int nb, int) {
+        const float g = m_g[current] + static_cast<float>(m_graph.cost(current));
+        if (g < m_g[nb]) {
+            m_g[nb] = g;
+            const auto [row, col] = m_graph.cell(nb);
+            m_open.push({g + (std::abs(row - startRow) + std::abs(col - startCol)) * m_graph.minCost(), nb});
+        }
+    });
+}
+
+bool SpaceTimeSearch::search(int start, int goal, int startTime, int window, const ReservationTable& reservations, GoalDistance& distance, std::vector<int>& cells)
+{
+    cells.clear();
+    m_lastExpanded = 0;
+    if (distance(start) == std::numeric_limits<double>::infinity() || !reservations.cellFree(start, startTime)) return false;
+    // someone else stays on the goal for good
+    if (window <= 0 && reservations.parkedFrom(goal) != ReservationTable::kNever) return false;
+
+    // without a window every time after the last reservation looks the same (only parked cells are taken), so all of
+    // them share one state. that keeps the search finite even if the agent has to wait a long time
+    const int end = startTime + window;
+    const int horizon = window > 0 ? end : std::max(startTime, reservations.lastTime() + 1);
+    auto state = [&](int cell, int time) {
+        return static_cast<std::uint64_t>(std::min(time, horizon) - startTime) * m_graph.size() + cell;
+    };
+
+    m_nodes.clear();
+    m_nodeOf.clear();
+    m_queue.clear();
+    auto push = [&](const Node& node, double h) {
+        m_nodeOf[state(node.cell, node.time)] = static_cast<int>(m_nodes.size());
+        m_queue.push_back({node.g + h, -node.g, static_cast<int>(m_nodes.size())});
+        std::push_heap(m_queue.begin(), m_queue.end(), std::greater<>());
+        m_nodes.push_back(node);
+    };
+    push({start, startTime, 0.0, -1, false}, distance(start));
+
+    while (!m_queue.empty()) {
+        std::pop_heap(m_queue.begin(), m_queue.end(), std::greater<>());
+        const int current = std::get<2>(m_queue.back());
+        m_queue.pop_back();
+        // replaced by a cheaper node for the same state
+        if (m_nodes[current].closed || m_nodeOf[state(m_nodes[current].cell, m_nodes[current].time)] != current) continue;
+        m_nodes[current].closed = true;
+        ++m_lastExpanded;
+        const Node node = m_nodes[current];
+
+        const bool done = window > 0 ? node.time == end : node.cell == goal && node.time > reservations.lastUse(goal);
+        if (done) {
+            for (int n = current; n != -1; n = m_nodes[n].parent) cells.push_back(m_nodes[n].cell);
+            std::reverse(cells.begin(), cells.end());
+            return true;
+        }
+
+        // wait (direction -1) or move
+        for (int direction = -1; direction < 4; ++direction) {
+            const int next = direction < 0 ? node.cell : m_graph.neighbour(node.cell, direction);
+            if (next < 0) continue;
+            const int time = node.time + 1;
+            if (!reservations.cellFree(next, time) || (next != node.cell && !reservations.moveFree(node.cell, next, node.time))) continue;
+            const double h = distance(next);
+            if (h == std::numeric_limits<double>::infinity()) continue;
+
+            const double g = node.g + stepCost(m_graph, node.cell, next, goal);
+            const auto it = m_nodeOf.find(state(next, time));
+            if (it != m_nodeOf.end() && (m_nodes[it->second].closed || m_nodes[it->second].g <= g)) continue;
+            push({next, time, g, current, false}, h);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef SPACETIMESEARCH_H
+#define SPACETIMESEARCH_H
+
+#include "gridgraph.h"
+#include "reservationtable.h"
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Exact cost from any cell to one goal ignoring other agents, used as heuristic by SpaceTimeSearch.
+// Computed on demand by a backward A* from the goal towards the agent's start that is resumed until the asked cell is
+// settled (reverse resumable A*), so only the cells near the agent's route are ever computed.
+class GoalDistance {
+public:
+    GoalDistance(const GridGraph& graph, int goal, int start);
+
+    // infinity if the goal cant be reached from the cell
+    double operator()(int cell);
+
+    // finishes the backward search. afterwards operator() only reads, so several threads can share the table
+    void settleAll();
+
+private:
+    // pops one queue entry and settles it (unless it is stale)
+    void settleNext();
+
+    const GridGraph& m_graph;
+    int m_start;
+    std::vector<float> m_g;
+    std::vector<char> m_settled;
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> m_open;
+};
+
+// Single agent A* over (cell, time) for the multi-agent planners.
+// Every time step the agent either moves to a neighbour or waits. Cells and moves taken in the ReservationTable are off
+// limits (for cooperative A* those are other agents' paths, for conflict based search the agent's constraints).
+// Moving costs the terrain of the entered cell as usual, waiting costs the terrain of the cell the agent waits on
+// (nothing on its goal). The node storage is kept between calls, so one object per thread avoids reallocating it.
+class SpaceTimeSearch {
+public:
+    explicit SpaceTimeSearch(const GridGraph& graph) : m_graph(graph) {}
+
+    // path from start at startTime. with window > 0 the search stops at startTime + window, otherwise on the goal once
+    // nothing else is reserved there later. fills cells with the cell of every time step, false if there is no path
+    bool search(int start, int goal, int startTime, int window, const ReservationTable& reservations, GoalDistance& distance, std::vector<int>& cells);
+
+    // (cell, time) states expanded by the last search()
+    int lastExpanded() const noexcept { return m_lastExpanded; }
+
+    // cost of going from cell to next in one time step (next == cell is waiting)
+    static double stepCost(const GridGraph& graph, int cell, int next, int goal) {
+        return next == cell && cell == goal ? 0.0 : graph.cost(next);
+    }
+
+private:
+    struct Node {
+        int cell;
+        int time;
+        double g;
+        int parent;
+        bool closed;
+    };
+
+    const GridGraph& m_graph;
+    std::vector<Node> m_nodes;
+    std::unordered_map<std::uint64_t, int> m_nodeOf;
+    // {f, -g, node} min-heap: lowest f first, deeper nodes first on ties
+    std::vector<std::tuple<double, double, int>> m_queue;
+    int m_lastExpanded = 0;
+};
+
+#endif // SPACETIMESEARCH_H
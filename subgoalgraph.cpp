@@ -0,0 +1,280 @@
+#include "subgoalgraph.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+SubgoalGraph::SubgoalGraph(const GridModel& model, const CostProfile& profile)
+    : m_graph(model, profile)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const int n = m_graph.size();
+
+    // mark the subgoals, then connect each of them (every cell only writes its own edge list, so this runs in parallel)
+    m_isSubgoal.assign(n, 0);
+    m_edges.assign(n, {});
+    for (int cell = 0; cell < n; ++cell) m_isSubgoal[cell] = computeSubgoal(cell);
+    WorkerPool::instance().parallelFor(n, [this](int begin, int end) {
+        for (int cell = begin; cell < end; ++cell) {
+            if (m_isSubgoal[cell]) connect(cell);
+        }
+    });
+
+    m_buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int SubgoalGraph::manhattan(int a, int b) const
+{
+    const auto [ar, ac] = m_graph.cell(a);
+    const auto [br, bc] = m_graph.cell(b);
+    return std::abs(ar - br) + std::abs(ac - bc);
+}
+
+bool SubgoalGraph::computeSubgoal(int cell) const
+{
+    if (!m_graph.passable(cell)) return false;
+    const double cost = m_graph.cost(cell);
+    const int rows = m_graph.rowCount();
+    const int cols = m_graph.colCount();
+    const auto [row, col] = m_graph.cell(cell);
+
+    // boundary subgoal: a passable neighbour with a different terrain cost
+    for (int direction = 0; direction < 4; ++direction) {
+        const int nb = m_graph.neighbour(cell, direction);
+        if (nb >= 0 && m_graph.cost(nb) != cost) return true;
+    }
+
+    // corner subgoal: the diagonal cell is something else (wall or other terrain) but both cells in between are
+    // the same terrain as this one, so this cell sits right at a convex corner a path might have to bend around
+    for (int dr : {-1, 1}) {
+        for (int dc : {-1, 1}) {
+            const int r = row + dr;
+            const int c = col + dc;
+            if (r < 0 || r >= rows || c < 0 || c >= cols) continue;
+            if (m_graph.cost(r * cols + c) != cost && m_graph.cost(r * cols + col) == cost && m_graph.cost(row * cols + c) == cost) return true;
+        }
+    }
+    return false;
+}
+
+template <typename Found>
+void SubgoalGraph::explore(int from, int target, Found&& found) const
+{
+    const double regionCost = m_graph.cost(from);
+    const int rows = m_graph.rowCount();
+    const int cols = m_graph.colCount();
+    const auto [r0, c0] = m_graph.cell(from);
+
+    // cells on the row/column through "from" belong to two quadrants, remember what was reported already
+    std::vector<int> reported;
+
+    // pass[k] = the staircase can continue through column k of the previous / current row
+    std::vector<char> previousPass(cols), currentPass(cols);
+
+    for (int sr : {-1, 1}) {
+        for (int sc : {-1, 1}) {
+            const int width = sc > 0 ? cols - c0 : c0 + 1;
+            for (int j = 0; r0 + sr * j >= 0 && r0 + sr * j < rows; ++j) {
+                const int row = r0 + sr * j;
+                bool anyReached = false;
+                for (int k = 0; k < width; ++k) {
+                    const int cell = row * cols + c0 + sc * k;
+                    bool reached;
+                    if (j == 0 && k == 0) {
+                        reached = true;
+                    } else {
+                        // a staircase cell is reached from the cell before it in the row or the column
+                        reached = m_graph.cost(cell) == regionCost && ((j > 0 && previousPass[k]) || (k > 0 && currentPass[k - 1]));
+                    }
+                    bool passes = reached;
+                    if (reached && cell != from && (m_isSubgoal[cell] || cell == target)) {
+                        // stop at subgoals, paths going further are covered by that subgoal's own edges
+                        if (std::find(reported.begin(), reported.end(), cell) == reported.end()) {
+                            reported.push_back(cell);
+                            found(cell);
+                        }
+                        passes = false;
+                    }
+                    currentPass[k] = passes;
+                    anyReached = anyReached || reached;
+                }
+                // nothing reached in this row, so nothing further out can be reached either
+                if (!anyReached) break;
+                std::swap(previousPass, currentPass);
+            }
+        }
+    }
+}
+
+void SubgoalGraph::connect(int cell)
+{
+    auto& edges = m_edges[cell];
+    edges.clear();
+    if (!m_isSubgoal[cell]) {
+        edges.shrink_to_fit();
+        return;
+    }
+
+    // staircases through this cell's terrain, every step costs the terrain's cost
+    const double cost = m_graph.cost(cell);
+    explore(cell, -1, [&](int other) { edges.push_back({other, manhattan(cell, other) * cost}); });
+
+    // single steps across a terrain boundary
+    m_graph.forEachNeighbour(cell, [&](int nb, int) {
+        if (m_graph.cost(nb) != cost) edges.push_back({nb, m_graph.cost(nb)});
+    });
+}
+
+void SubgoalGraph::cellChanged(const GridModel& model, uint8_t row, uint8_t col)
+{
+    // only cells in the 3x3 block around the edit can change their subgoal status
+    std::vector<int> block;
+    for (int r = row - 1; r <= row + 1; ++r) {
+        for (int c = col - 1; c <= col + 1; ++c) {
+            if (r >= 0 && r < m_graph.rowCount() && c >= 0 && c < m_graph.colCount()) block.push_back(m_graph.index(r, c));
+        }
+    }
+
+    // subgoals whose staircases pass through (or stop at) the block are exactly the subgoals a staircase search
+    // from the block finds, so collect them once with the old terrain and once with the new one
+    std::vector<int> affected = block;
+    auto collect = [&]() {
+        for (int cell : block) {
+            if (m_graph.passable(cell)) explore(cell, -1, [&affected](int other) { affected.push_back(other); });
+        }
+    };
+    collect();
+    m_graph.refreshCell(model, row, col);
+    for (int cell : block) m_isSubgoal[cell] = computeSubgoal(cell);
+    collect();
+
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+    for (int cell : affected) connect(cell);
+}
+
+void SubgoalGraph::refine(int a, int b, std::vector<int>& cells) const
+{
+    // single step across a terrain boundary
+    if (manhattan(a, b) == 1) {
+        cells.push_back(b);
+        return;
+    }
+
+    // which cells inside the rectangle between a and b can still reach b with a staircase (filled backwards from b)
+    const double regionCost = m_graph.cost(b);
+    const auto [ar, ac] = m_graph.cell(a);
+    const auto [br, bc] = m_graph.cell(b);
+    const int sr = br > ar ? 1 : -1;
+    const int sc = bc > ac ? 1 : -1;
+    const int height = std::abs(br - ar) + 1;
+    const int width = std::abs(bc - ac) + 1;
+    std::vector<char> reachesGoal(static_cast<size_t>(height) * width, 0);
+    for (int j = height - 1; j >= 0; --j) {
+        for (int k = width - 1; k >= 0; --k) {
+            const int cell = m_graph.index(ar + sr * j, ac + sc * k);
+            if (j == height - 1 && k == width - 1) {
+                reachesGoal[j * width + k] = 1;
+            } else if (j == 0 && k == 0) {
+                reachesGoal[0] = (j + 1 < height && reachesGoal[width]) || (k + 1 < width && reachesGoal[1]);
+            } else if (m_graph.cost(cell) == regionCost) {
+                reachesGoal[j * width + k] = (j + 1 < height && reachesGoal[(j + 1) * width + k]) || (k + 1 < width && reachesGoal[j * width + k + 1]);
+            }
+        }
+    }
+
+    // walk from a, always stepping to a cell that can still reach b
+    int j = 0, k = 0;
+    while (j != height - 1 || k != width - 1) {
+        if (j + 1 < height && reachesGoal[(j + 1) * width + k]) {
+            ++j;
+        } else {
+            ++k;
+        }
+        cells.push_back(m_graph.index(ar + sr * j, ac + sc * k));
+    }
+}
+
+Pathfinder::PathResult SubgoalGraph::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const
+{
+    Pathfinder::PathResult result;
+    result.totalCost = -1;
+    if (start.first >= m_graph.rowCount() || start.second >= m_graph.colCount()
+        || goal.first >= m_graph.rowCount() || goal.second >= m_graph.colCount()) return result;
+    const int s = m_graph.index(start);
+    const int t = m_graph.index(goal);
+    if (!m_graph.passable(s) || !m_graph.passable(t)) return result;
+
+    // temporary edges: start -> subgoals it reaches directly (or straight to the goal), subgoals -> goal
+    std::vector<Edge> startEdges;
+    explore(s, t, [&](int other) { startEdges.push_back({other, manhattan(s, other) * m_graph.cost(s)}); });
+    if (m_isSubgoal[s]) {
+        for (const Edge& edge : m_edges[s]) startEdges.push_back(edge);
+    }
+    std::unordered_map<int, double> intoGoal;
+    explore(t, -1, [&](int other) { intoGoal[other] = manhattan(other, t) * m_graph.cost(t); });
+
+    // A* over the subgoal graph. Manhattan distance times the cheapest terrain never overestimates
+    const double minCost = m_graph.minCost();
+    auto heuristic = [&](int cell) { return manhattan(cell, t) * minCost; };
+    std::unordered_map<int, double> g;
+    std::unordered_map<int, int> parent;
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+    g[s] = 0.0;
+    queue.push({heuristic(s), s});
+
+    auto relax = [&](int from, int to, double weight) {
+        const double newCost = g[from] + weight;
+        const auto it = g.find(to);
+        if (it == g.end() || newCost < it->second) {
+            g[to] = newCost;
+            parent[to] = from;
+            queue.push({newCost + heuristic(to), to});
+        }
+    };
+
+    while (!queue.empty()) {
+        const auto [f, current] = queue.top();
+        queue.pop();
+        const double currentCost = g[current];
+        // stale entry
+        if (f > currentCost + heuristic(current)) continue;
+
+        if (current == t) {
+            // chain of subgoals s ... t, then every edge refined into cells
+            std::vector<int> chain;
+            for (int cell = t; cell != s; cell = parent[cell]) chain.push_back(cell);
+            chain.push_back(s);
+            std::reverse(chain.begin(), chain.end());
+
+            std::vector<int> cells {s};
+            for (size_t i = 0; i + 1 < chain.size(); ++i) refine(chain[i], chain[i + 1], cells);
+            for (int cell : cells) result.path.push_back(m_graph.cell(cell));
+            result.totalCost = currentCost;
+            return result;
+        }
+
+        if (current == s) {
+            for (const Edge& edge : startEdges) relax(current, edge.to, edge.weight);
+        } else {
+            for (const Edge& edge : m_edges[current]) relax(current, edge.to, edge.weight);
+        }
+        const auto goalEdge = intoGoal.find(current);
+        if (goalEdge != intoGoal.end()) relax(current, t, goalEdge->second);
+    }
+    return result;
+}
+
+SubgoalGraph::Stats SubgoalGraph::stats() const
+{
+    Stats stats;
+    for (size_t cell = 0; cell < m_edges.size(); ++cell) {
+        stats.subgoals += m_isSubgoal[cell];
+        stats.edges += m_edges[cell].size();
+    }
+    stats.buildMilliseconds = m_buildMilliseconds;
+    return stats;
+}
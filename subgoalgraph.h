@@ -0,0 +1,73 @@
+#ifndef SUBGOALGRAPH_H
+#define SUBGOALGRAPH_H
+
+#include "gridgraph.h"
+#include "pathfinder.h"
+#include <cstdint>
+#include <vector>
+
+// Simple subgoal graph (SSG) for the 4-connected grid with terrain costs.
+// Cheapest paths only ever need to change their general direction at a few special cells ("subgoals"):
+//   - corner subgoals: cells diagonally next to the convex corner of a wall (or of a patch of different terrain),
+//     the places a path has to bend around.
+//   - boundary subgoals: cells next to a cell of different terrain cost, the places a path crosses between terrains.
+// Between two subgoals that can reach each other with a straight "staircase" (every step goes the same way both in rows
+// and in columns) through one kind of terrain, the cost is simply the step count times that terrain's cost.
+// Those pairs become the edges of a small graph, A* runs on that graph instead of on every cell, and each edge is then
+// turned back into individual cells for the GridView.
+// The graph repairs itself around edited cells with cellChanged() instead of being rebuilt.
+class SubgoalGraph {
+public:
+    struct Stats {
+        int subgoals = 0;
+        size_t edges = 0;
+        double buildMilliseconds = 0;
+    };
+
+    // finds all subgoals of the grid and connects them. subgoals depend on where the cost changes, so the graph holds
+    // for the costs of one profile (build one per profile)
+    explicit SubgoalGraph(const GridModel& model, const CostProfile& profile = CostProfile::standard());
+
+    // updates subgoals and edges around a cell that was just edited in the model
+    void cellChanged(const GridModel& model, uint8_t row, uint8_t col);
+
+    // cheapest path through the subgoal graph, refined back into cells (same format as Pathfinder::findPath())
+    Pathfinder::PathResult findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal) const;
+
+    // true if the cell is a subgoal (handy for drawing the graph)
+    bool isSubgoal(uint8_t row, uint8_t col) const { return m_isSubgoal[m_graph.index(row, col)]; }
+
+    Stats stats() const;
+
+private:
+    struct Edge {
+        int to;
+        double weight;
+    };
+
+    // checks the corner / boundary rules for one cell
+    bool computeSubgoal(int cell) const;
+
+    // staircase search from "from" through cells with the same cost as "from", one quadrant at a time.
+    // calls found(cell) for every subgoal (or the extra target cell) reached without passing through another subgoal.
+    template <typename Found>
+    void explore(int from, int target, Found&& found) const;
+
+    // recomputes the outgoing edges of one subgoal
+    void connect(int cell);
+
+    // cells of a staircase from a to b through terrain with the cost of b (a and b must be connected)
+    void refine(int a, int b, std::vector<int>& cells) const;
+
+    // Manhattan distance between two cells
+    int manhattan(int a, int b) const;
+
+    GridGraph m_graph;
+    double m_buildMilliseconds = 0;
+
+    // subgoal flag and outgoing edges for every cell (empty for non subgoals)
+    std::vector<char> m_isSubgoal;
+    std::vector<std::vector<Edge>> m_edges;
+};
+
+#endif // SUBGOALGRAPH_H
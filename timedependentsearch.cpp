@@ -0,0 +1,88 @@
+#include "timedependentsearch.h"
+#include "gridgraph.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+
+TimeDependentSearch::TimeDependentSearch(const GridModel& model, const TimeSchedule& schedule)
+    : m_model(model)
+    , m_schedule(schedule)
+{
+}
+
+TimeDependentSearch::Result TimeDependentSearch::findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal, double startTime) const
+{
+    // cellState() throws std::out_of_range for cells outside of the grid
+    m_model.cellState(start.first, start.second);
+    m_model.cellState(goal.first, goal.second);
+
+    Result result;
+    const int rows = m_model.rowCount();
+    const int cols = m_model.colCount();
+    const int s = start.first * cols + start.second;
+    const int t = goal.first * cols + goal.second;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    // Manhattan distance at the cheapest cost any cell ever has
+    const double minCost = m_schedule.minCost();
+    auto h = [&](int cell) { return (std::abs(cell / cols - goal.first) + std::abs(cell % cols - goal.second)) * minCost; };
+
+    std::vector<double> arrival(rows * cols, infinity);
+    std::vector<double> departure(rows * cols, infinity);  // when the agent left the parent to move into the cell
+    std::vector<int> parent(rows * cols, -1);
+    std::vector<char> closed(rows * cols, 0);
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> open;
+    arrival[s] = startTime;
+    open.push({startTime + h(s), s});
+
+    while (!open.empty()) {
+        const int cell = open.top().second;
+        open.pop();
+        if (closed[cell]) continue;
+        closed[cell] = 1;
+        ++result.expanded;
+
+        if (cell == t) {
+            std::vector<int> cells;
+            for (int c = t; c != -1; c = parent[c]) cells.push_back(c);
+            std::reverse(cells.begin(), cells.end());
+            for (size_t i = 0; i < cells.size(); ++i) {
+                result.path.push_back({static_cast<uint8_t>(cells[i] / cols), static_cast<uint8_t>(cells[i] % cols)});
+                result.arrivals.push_back(arrival[cells[i]]);
+                result.waits.push_back(i + 1 < cells.size() ? departure[cells[i + 1]] - arrival[cells[i]] : 0.0);
+            }
+            result.totalCost = arrival[t] - startTime;
+            return result;
+        }
+
+        const int row = cell / cols;
+        const int col = cell % cols;
+        for (int direction = 0; direction < 4; ++direction) {
+            const int nr = row + GridGraph::dr[direction];
+            const int nc = col + GridGraph::dc[direction];
+            if (nr < 0 || nr >= rows || nc < 0 || nc >= cols) continue;
+            const int next = nr * cols + nc;
+            if (closed[next]) continue;
+
+            // leave now, or at one of the next cell's later changes. within one stretch of unchanged terrain leaving
+            // later only arrives later, and once leaving is no earlier than the best arrival, nothing can beat it
+            double best = arrival[next];
+            double bestDeparture = infinity;
+            for (double leave = arrival[cell]; leave < best; leave = m_schedule.nextChange(next, leave)) {
+                const double cost = m_schedule.costAt(next, leave);
+                if (cost >= 0 && leave + cost < best) {
+                    best = leave + cost;
+                    bestDeparture = leave;
+                }
+            }
+            if (bestDeparture == infinity) continue;
+            arrival[next] = best;
+            departure[next] = bestDeparture;
+            parent[next] = cell;
+            open.push({best + h(next), next});
+        }
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef TIMEDEPENDENTSEARCH_H
+#define TIMEDEPENDENTSEARCH_H
+
+#include "gridmodel.h"
+#include "timeschedule.h"
+#include <cstdint>
+#include <vector>
+
+// Earliest arrival paths on terrain that changes over time (TimeSchedule).
+// Moving into a cell takes as long as it costs at the moment the agent steps into it, and the agent may wait anywhere
+// (a gate that opens at time 10 is worth waiting for). Because waiting is allowed, arriving earlier at a cell is never
+// worse, so the search only needs one label per cell like ordinary A*, not one per time step: when it relaxes a move
+// it tries leaving right away and leaving at each later time the target cell's terrain changes (nothing between two
+// changes can be better), and stops as soon as leaving later cant beat the best arrival found.
+// Only the cell being entered is checked, a gate closing behind or on top of an agent doesnt affect it.
+// Reads the model and the schedule directly, so there is nothing to build or keep up to date.
+class TimeDependentSearch {
+public:
+    struct Result {
+        std::vector<std::pair<uint8_t, uint8_t>> path;  // start ... goal
+        std::vector<double> arrivals;                    // time the agent reaches each cell of the path
+        std::vector<double> waits;                       // time it waits on each cell before moving on
+        double totalCost = -1;                           // time from startTime to the goal, -1 if there is no path
+        int expanded = 0;
+    };
+
+    TimeDependentSearch(const GridModel& model, const TimeSchedule& schedule);
+
+    // earliest arrival path leaving start at startTime. throws std::out_of_range for cells outside the grid
+    Result findPath(const std::pair<uint8_t, uint8_t>& start, const std::pair<uint8_t, uint8_t>& goal, double startTime = 0.0) const;
+
+private:
+    const GridModel& m_model;
+    const TimeSchedule& m_schedule;
+};
+
+#endif // TIMEDEPENDENTSEARCH_H
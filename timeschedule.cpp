@@ -0,0 +1,87 @@
+#include "timeschedule.h"
+#include "pathfinder.h"
+#include <algorithm>
+#include <stdexcept>
+
+TimeSchedule::TimeSchedule(const GridModel& model)
+    : m_model(model)
+{
+}
+
+void TimeSchedule::schedule(uint8_t row, uint8_t col, double from, double to, GridModel::CellType type)
+{
+    // cellState() throws std::out_of_range for cells outside of the grid
+    m_model.cellState(row, col);
+    if (!(from < to)) return;
+    std::vector<Change>& changes = m_changes[row * m_model.colCount() + col];
+
+    // the terrain that applies again from "to" on: whatever was in effect there before this interval
+    int8_t after = kModel;
+    for (const Change& change : changes) {
+        if (change.time <= to) after = change.type;
+    }
+
+    // drop the changes inside [from, to] and put in the interval's own start and end
+    changes.erase(std::remove_if(changes.begin(), changes.end(), [&](const Change& change) { return change.time >= from && change.time <= to; }),
+                  changes.end());
+    changes.push_back({from, static_cast<int8_t>(type)});
+    if (to != kForever) changes.push_back({to, after});
+    std::sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) { return a.time < b.time; });
+}
+
+void TimeSchedule::clearCell(uint8_t row, uint8_t col)
+{
+    m_model.cellState(row, col);
+    m_changes.erase(row * m_model.colCount() + col);
+}
+
+void TimeSchedule::clear()
+{
+    m_changes.clear();
+}
+
+GridModel::CellType TimeSchedule::cellStateAt(uint8_t row, uint8_t col, double time) const
+{
+    const GridModel::CellType base = m_model.cellState(row, col);
+    const auto it = m_changes.find(row * m_model.colCount() + col);
+    if (it == m_changes.end()) return base;
+
+    // last change at or before the time
+    const std::vector<Change>& changes = it->second;
+    const auto next = std::upper_bound(changes.begin(), changes.end(), time, [](double t, const Change& change) { return t < change.time; });
+    if (next == changes.begin() || std::prev(next)->type == kModel) return base;
+    return static_cast<GridModel::CellType>(std::prev(next)->type);
+}
+
+double TimeSchedule::costAt(int cell, double time) const
+{
+    return Pathfinder::getCost(cellStateAt(cell / m_model.colCount(), cell % m_model.colCount(), time));
+}
+
+double TimeSchedule::nextChange(int cell, double time) const
+{
+    const auto it = m_changes.find(cell);
+    if (it == m_changes.end()) return kForever;
+    const std::vector<Change>& changes = it->second;
+    const auto next = std::upper_bound(changes.begin(), changes.end(), time, [](double t, const Change& change) { return t < change.time; });
+    return next == changes.end() ? kForever : next->time;
+}
+
+double TimeSchedule::minCost() const
+{
+    double best = std::numeric_limits<double>::infinity();
+    for (int row = 0; row < m_model.rowCount(); ++row) {
+        for (int col = 0; col < m_model.colCount(); ++col) {
+            const double cost = Pathfinder::getCost(m_model.cellState(row, col));
+            if (cost >= 0) best = std::min(best, cost);
+        }
+    }
+    for (const auto& [cell, changes] : m_changes) {
+        for (const Change& change : changes) {
+            if (change.type == kModel) continue;
+            const double cost = Pathfinder::getCost(static_cast<GridModel::CellType>(change.type));
+            if (cost >= 0) best = std::min(best, cost);
+        }
+    }
+    return best == std::numeric_limits<double>::infinity() ? 1.0 : best;
+}
@@ -0,0 +1,56 @@
+#ifndef TIMESCHEDULE_H
+#define TIMESCHEDULE_H
+
+#include "gridmodel.h"
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// Scheduled terrain changes on top of a GridModel: gates that open at some time, bridges that close, ground that turns
+// rough for a while. Each scheduled cell keeps a short sorted list of the times its terrain changes (a step function
+// of time), every other cell simply has the model's terrain at all times, so the overlay costs nothing for them.
+// Times are in the same unit as path costs (moving into a cell takes as long as it costs), see TimeDependentSearch.
+class TimeSchedule {
+public:
+    static constexpr double kForever = std::numeric_limits<double>::infinity();
+
+    explicit TimeSchedule(const GridModel& model);
+
+    // the cell behaves like type during [from, to), replacing whatever was scheduled there before.
+    // throws std::out_of_range for cells outside the grid
+    void schedule(uint8_t row, uint8_t col, double from, double to, GridModel::CellType type);
+
+    // removes every scheduled change of one cell / of all cells
+    void clearCell(uint8_t row, uint8_t col);
+    void clear();
+
+    // terrain of the cell at the given time
+    GridModel::CellType cellStateAt(uint8_t row, uint8_t col, double time) const;
+
+    // cost of moving into the cell at the given time (-1 while it is a wall), cells numbered row * cols + col
+    double costAt(int cell, double time) const;
+
+    // first time after the given one at which the cell's terrain changes (kForever if it never does)
+    double nextChange(int cell, double time) const;
+
+    // cheapest cost any passable cell has at any time (for admissible heuristics)
+    double minCost() const;
+
+    // number of cells with scheduled changes
+    int scheduledCells() const noexcept { return static_cast<int>(m_changes.size()); }
+
+private:
+    // from this time on the cell has this terrain (kModel: whatever the model says)
+    struct Change {
+        double time;
+        int8_t type;
+    };
+    static constexpr int8_t kModel = -1;
+
+    const GridModel& m_model;
+    // sorted by time, the cell has the model's terrain before the first change
+    std::unordered_map<int, std::vector<Change>> m_changes;
+};
+
+#endif // TIMESCHEDULE_H
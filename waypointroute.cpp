@@ -0,0 +1,150 @@
+#include "waypointroute.h"
+#include "gridgraph.h"
+#include "nearesttargetsearch.h"
+#include "workerpool.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+WaypointRoute::WaypointRoute(const GridModel& model)
+    : m_model(model)
+{
+}
+
+WaypointRoute::Result WaypointRoute::findRoute(const std::pair<uint8_t, uint8_t>& start, const std::vector<std::pair<uint8_t, uint8_t>>& waypoints,
+                                               const std::pair<uint8_t, uint8_t>& goal, bool optimizeOrder) const
+{
+    // all points of the route, cellState() throws std::out_of_range for cells outside of the grid
+    std::vector<std::pair<uint8_t, uint8_t>> points;
+    points.reserve(waypoints.size() + 2);
+    points.push_back(start);
+    points.insert(points.end(), waypoints.begin(), waypoints.end());
+    points.push_back(goal);
+    for (const auto& point : points) m_model.cellState(point.first, point.second);
+
+    if (optimizeOrder && waypoints.size() > 1 && waypoints.size() <= static_cast<size_t>(kMaxOptimizedWaypoints)) return routeOptimized(points);
+    return routeInOrder(points);
+}
+
+WaypointRoute::Result WaypointRoute::routeInOrder(const std::vector<std::pair<uint8_t, uint8_t>>& points) const
+{
+    const int legs = static_cast<int>(points.size()) - 1;
+    std::vector<NearestTargetSearch::Result> legResults(legs);
+    const NearestTargetSearch search(m_model);
+    WorkerPool::instance().parallelFor(legs, [&](int begin, int end) {
+        for (int leg = begin; leg < end; ++leg) legResults[leg] = search.findNearest(points[leg], {points[leg + 1]});
+    });
+
+    // stitch the legs, every leg starts on the last cell of the previous one
+    Result result;
+    for (int w = 0; w < legs - 1; ++w) result.order.push_back(w);
+    double total = 0.0;
+    for (int leg = 0; leg < legs; ++leg) {
+        if (legResults[leg].totalCost < 0) return {};
+        total += legResults[leg].totalCost;
+        result.legCosts.push_back(legResults[leg].totalCost);
+        result.path.insert(result.path.end(), legResults[leg].path.begin() + (leg == 0 ? 0 : 1), legResults[leg].path.end());
+    }
+    result.totalCost = total;
+    return result;
+}
+
+WaypointRoute::Result WaypointRoute::routeOptimized(const std::vector<std::pair<uint8_t, uint8_t>>& points) const
+{
+    const GridGraph graph(m_model);
+    const int count = static_cast<int>(points.size());
+    const int waypoints = count - 2;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    std::vector<int> pointCells(count);
+    for (int i = 0; i < count; ++i) pointCells[i] = graph.index(points[i]);
+
+    // one Dijkstra from the start and every waypoint (the goal is only ever a target), stopping once all points are
+    // settled. the parent trees are kept to read the legs from afterwards
+    std::vector<std::vector<double>> matrix(count - 1, std::vector<double>(count, infinity));
+    std::vector<std::vector<int>> parents(count - 1);
+    WorkerPool::instance().parallelFor(count - 1, [&](int begin, int end) {
+        std::vector<double> dist(graph.size());
+        std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> queue;
+        for (int source = begin; source < end; ++source) {
+            std::fill(dist.begin(), dist.end(), infinity);
+            std::vector<int>& parent = parents[source];
+            parent.assign(graph.size(), -1);
+            queue = {};
+            dist[pointCells[source]] = 0.0;
+            queue.push({0.0, pointCells[source]});
+            int remaining = count;
+            while (!queue.empty() && remaining > 0) {
+                const auto [d, cell] = queue.top();
+                queue.pop();
+                if (d > dist[cell]) continue;
+                remaining -= static_cast<int>(std::count(pointCells.begin(), pointCells.end(), cell));
+                graph.forEachNeighbour(cell, [&](int next, int) {
+                    const double newDist = d + graph.cost(next);
+                    if (newDist < dist[next]) {
+                        dist[next] = newDist;
+                        parent[next] = cell;
+                        queue.push({newDist, next});
+                    }
+                });
+            }
+            for (int target = 0; target < count; ++target) matrix[source][target] = dist[pointCells[target]];
+        }
+    });
+
+    // Held-Karp: best[mask][last] = cheapest way from the start through the waypoints in mask, ending at last
+    const int masks = 1 << waypoints;
+    std::vector<double> best(static_cast<size_t>(masks) * waypoints, infinity);
+    std::vector<int> previous(static_cast<size_t>(masks) * waypoints, -1);
+    for (int w = 0; w < waypoints; ++w) best[(1 << w) * waypoints + w] = matrix[0][w + 1];
+    for (int mask = 1; mask < masks; ++mask) {
+        for (int last = 0; last < waypoints; ++last) {
+            const double cost = best[mask * waypoints + last];
+            if (!(mask & (1 << last)) || cost == infinity) continue;
+            for (int next = 0; next < waypoints; ++next) {
+                if (mask & (1 << next)) continue;
+                const int nextMask = mask | (1 << next);
+                const double newCost = cost + matrix[last + 1][next + 1];
+                if (newCost < best[nextMask * waypoints + next]) {
+                    best[nextMask * waypoints + next] = newCost;
+                    previous[nextMask * waypoints + next] = last;
+                }
+            }
+        }
+    }
+    int last = -1;
+    double total = infinity;
+    for (int w = 0; w < waypoints; ++w) {
+        const double cost = best[(masks - 1) * waypoints + w] + matrix[w + 1][count - 1];
+        if (cost < total) {
+            total = cost;
+            last = w;
+        }
+    }
+    if (last < 0) return {};
+
+    Result result;
+    for (int mask = masks - 1, w = last; w != -1;) {
+        result.order.push_back(w);
+        const int before = previous[mask * waypoints + w];
+        mask &= ~(1 << w);
+        w = before;
+    }
+    std::reverse(result.order.begin(), result.order.end());
+
+    // legs straight from the Dijkstra trees: point index of every stop, then walk each tree back from the next stop
+    std::vector<int> stops {0};
+    for (int w : result.order) stops.push_back(w + 1);
+    stops.push_back(count - 1);
+    result.path.push_back(points[0]);
+    for (size_t leg = 0; leg + 1 < stops.size(); ++leg) {
+        const std::vector<int>& parent = parents[stops[leg]];
+        std::vector<int> cells;
+        for (int cell = pointCells[stops[leg + 1]]; cell != pointCells[stops[leg]]; cell = parent[cell]) cells.push_back(cell);
+        for (auto it = cells.rbegin(); it != cells.rend(); ++it) result.path.push_back(graph.cell(*it));
+        result.legCosts.push_back(matrix[stops[leg]][stops[leg + 1]]);
+    }
+    result.totalCost = total;
+    return result;
+}
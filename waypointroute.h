@@ -0,0 +1,43 @@
+#ifndef WAYPOINTROUTE_H
+#define WAYPOINTROUTE_H
+
+#include "gridmodel.h"
+#include <cstdint>
+#include <vector>
+
+// Routes through a list of waypoints: start -> w1 -> w2 -> ... -> goal.
+// Every leg is an independent search, so all legs run at the same time on the WorkerPool and are stitched together
+// afterwards. Optionally the waypoint order is optimized as well (for up to kMaxOptimizedWaypoints waypoints): one
+// Dijkstra per start/waypoint (in parallel) gives the cost matrix between all points, the cheapest order is found
+// with the Held-Karp dynamic program, and the legs are read straight from the Dijkstra trees without searching again.
+// Reads the model while the searches run, so it must not be edited during a findRoute() call.
+class WaypointRoute {
+public:
+    // more waypoints than this are always visited in the given order (Held-Karp is exponential in the count)
+    static constexpr int kMaxOptimizedWaypoints = 12;
+
+    struct Result {
+        std::vector<std::pair<uint8_t, uint8_t>> path;  // start ... goal, passing every waypoint
+        double totalCost = -1;                          // -1 if some leg has no path
+        std::vector<int> order;                         // waypoint indices in the order they are visited
+        std::vector<double> legCosts;                   // cost of every leg (order.size() + 1 legs)
+    };
+
+    explicit WaypointRoute(const GridModel& model);
+
+    // route through all waypoints. with optimizeOrder the waypoints may be visited in any order (if there are at most
+    // kMaxOptimizedWaypoints of them), otherwise in the given order. throws std::out_of_range for cells outside the grid
+    Result findRoute(const std::pair<uint8_t, uint8_t>& start, const std::vector<std::pair<uint8_t, uint8_t>>& waypoints,
+                     const std::pair<uint8_t, uint8_t>& goal, bool optimizeOrder = false) const;
+
+private:
+    // legs in the given order, each solved by its own A* (in parallel)
+    Result routeInOrder(const std::vector<std::pair<uint8_t, uint8_t>>& points) const;
+
+    // cost matrix from one Dijkstra per point (in parallel), Held-Karp for the order, legs from the Dijkstra trees
+    Result routeOptimized(const std::vector<std::pair<uint8_t, uint8_t>>& points) const;
+
+    const GridModel& m_model;
+};
+
+#endif // WAYPOINTROUTE_H
@@ -0,0 +1,124 @@
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+WorkerPool::WorkerPool(unsigned threadCount)
+{
+    // hardware_concurrency() can return 0 if it is unknown, so always keep at least one worker
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // start the workers, each one sits in workerLoop() until the pool is destroyed
+    m_threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    // tell the workers to finish up
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeUp.notify_all();
+
+    // wait for every worker to exit
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+WorkerPool& WorkerPool::instance()
+{
+    // function local static is created once on first use and is thread safe since C++11
+    static WorkerPool pool;
+    return pool;
+}
+
+void WorkerPool::enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push(std::move(job));
+    }
+    m_wakeUp.notify_one();
+}
+
+void WorkerPool::workerLoop()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            // sleep until there is a job or the pool is shutting down
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeUp.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+            // only exit once the queue is empty so no submitted job is lost
+            if (m_stopping && m_jobs.empty()) return;
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        // run outside the lock so other workers can grab jobs at the same time
+        job();
+    }
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int begin, int end)>& body)
+{
+    if (count <= 0) return;
+
+    // a few chunks per thread so fast threads can pick up extra work when the chunks take different amounts of time
+    const int threads = static_cast<int>(threadCount()) + 1; // +1 for the calling thread
+    const int chunkCount = std::min(count, threads * 4);
+    const int chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    // state shared between the caller and the helper jobs.
+    // helpers may start after the caller already returned (when every chunk was taken), so it lives in a shared_ptr.
+    struct Shared {
+        std::atomic<int> nextChunk {0};
+        int finishedChunks = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable allDone;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    // claims chunks until there are none left, used by both the helpers and the caller.
+    // body is only touched while a chunk is claimed, and the caller doesnt return before every claimed chunk is done,
+    // so capturing it by reference is safe.
+    auto work = [shared, &body, count, chunkCount, chunkSize]() {
+        int chunk;
+        while ((chunk = shared->nextChunk.fetch_add(1)) < chunkCount) {
+            const int begin = chunk * chunkSize;
+            const int end = std::min(count, begin + chunkSize);
+            std::exception_ptr error;
+            try {
+                if (begin < end) body(begin, end);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            if (error && !shared->error) shared->error = error;
+            if (++shared->finishedChunks == chunkCount) shared->allDone.notify_all();
+        }
+    };
+
+    // one helper per worker (no more than there are chunks to share)
+    const int helpers = std::min<int>(static_cast<int>(threadCount()), chunkCount - 1);
+    for (int i = 0; i < helpers; ++i) {
+        enqueue(work);
+    }
+
+    // the caller helps instead of just waiting
+    work();
+
+    // wait for chunks still running on workers
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->allDone.wait(lock, [&shared, chunkCount]() { return shared->finishedChunks == chunkCount; });
+
+    // pass the first error on to the caller
+    if (shared->error) std::rethrow_exception(shared->error);
+}
@@ -0,0 +1,66 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads shared by the preprocessing engines (path databases, hierarchies, etc.).
+// Starting threads is expensive, so they are created once and then reused for every job.
+class WorkerPool {
+public:
+    // (explicit) so a number cant silently turn into a WorkerPool.
+    // threadCount = 0 means "one thread per hardware core".
+    explicit WorkerPool(unsigned threadCount = 0);
+
+    // tells all workers to stop once the queued jobs are finished and joins them
+    ~WorkerPool();
+
+    // pools own threads, copying one makes no sense
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // the pool shared by the whole application (created on first use)
+    static WorkerPool& instance();
+
+    // number of worker threads
+    unsigned threadCount() const noexcept { return static_cast<unsigned>(m_threads.size()); }
+
+    // queues a job and returns a std::future to wait for (and read) its result.
+    // exceptions thrown by the job are stored in the future and rethrown by future.get().
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        // packaged_task is move only but std::function needs a copyable object, so it is kept in a shared_ptr
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> future = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    // runs body(begin, end) over [0, count) split into chunks and waits until every chunk is done.
+    // the calling thread works on chunks too, so this is safe to call from inside a job running on the pool
+    // (if all workers are busy the caller simply does all the work itself instead of dead locking).
+    // body gets whole chunks so it can set up per thread scratch buffers once per chunk instead of once per item.
+    void parallelFor(int count, const std::function<void(int begin, int end)>& body);
+
+private:
+    // adds a job to the queue and wakes one worker
+    void enqueue(std::function<void()> job);
+
+    // loop run by every worker thread: wait for a job, run it, repeat
+    void workerLoop();
+
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_stopping = false;
+};
+
+#endif // WORKERPOOL_H